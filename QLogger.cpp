@@ -1,9 +1,19 @@
 #include "QLogger.h"
 
+#include "QLoggerWorkerPool.h"
 #include "QLoggerWriter.h"
 
 #include <QDateTime>
+#include <QDeadlineTimer>
 #include <QDir>
+#include <QThread>
+
+#include <csignal>
+#include <limits>
+
+#ifndef Q_OS_WIN
+#   include <signal.h>
+#endif
 
 Q_DECLARE_METATYPE(QLogger::LogLevel)
 Q_DECLARE_METATYPE(QLogger::LogMode)
@@ -19,33 +29,207 @@ void QLog_(const QString &module, LogLevel level, const QString &message, const
    QLoggerManager::getInstance()->enqueueMessage(module, level, message, function, file, line);
 }
 
-static const int QUEUE_LIMIT = 100;
+namespace
+{
+/**
+ * @brief Gets the identifier of the calling thread as it is logged. It is only formatted once per thread.
+ * @return The cached identifier.
+ */
+QString &currentThreadId()
+{
+   thread_local QString threadId;
+
+   if (threadId.isEmpty())
+      threadId = QString("%1").arg((quintptr)QThread::currentThread(), QT_POINTER_SIZE * 2, 16, QChar('0'));
 
-QLoggerManager *QLoggerManager::getInstance()
+   return threadId;
+}
+
+/**
+ * @brief Gets a random number from a xorshift generator of the calling thread, for the sampling of the modules.
+ */
+quint32 nextRandom()
 {
-   static QLoggerManager INSTANCE;
+   thread_local quint64 state = static_cast<quint64>(reinterpret_cast<quintptr>(&state))
+       ^ static_cast<quint64>(LogRecord::currentTimestamp()) ^ Q_UINT64_C(0x9E3779B97F4A7C15);
 
-   return &INSTANCE;
+   state ^= state >> 12;
+   state ^= state << 25;
+   state ^= state >> 27;
+
+   return static_cast<quint32>((state * Q_UINT64_C(0x2545F4914F6CDD1D)) >> 32);
 }
 
-bool QLoggerManager::addDestination(const QString &fileDest, const QString &module, LogLevel level,
-                                    const QString &fileFolderDestination, LogMode mode, LogFileDisplay fileSuffixIfFull,
-                                    LogMessageDisplays messageOptions, bool notify)
+/**
+ * @brief The writers reachable from the crash handler. A signal handler can neither lock nor allocate, so they are
+ * kept in a fixed array of atomic slots.
+ */
+constexpr auto MaxCrashWriters = 64;
+std::atomic<QLogger::QLoggerWriter *> crashWriters[MaxCrashWriters];
+
+/**
+ * @brief Maximum time in milliseconds a fatal message waits for its writer to flush it.
+ */
+constexpr auto FatalFlushTimeout = 5000;
+
+/**
+ * @brief Time in milliseconds between two reports of the messages suppressed by the rate limit of the call sites.
+ */
+constexpr auto SuppressionReportInterval = 1000;
+
+void registerCrashWriter(QLogger::QLoggerWriter *writer)
 {
-   QMutexLocker lock(&mMutex);
+   for (auto &slot : crashWriters)
+   {
+      QLogger::QLoggerWriter *expected = nullptr;
 
-   if (!mModuleDest.contains(module))
+      if (slot.compare_exchange_strong(expected, writer))
+         return;
+   }
+}
+
+void unregisterCrashWriter(QLogger::QLoggerWriter *writer)
+{
+   for (auto &slot : crashWriters)
    {
-      const auto log = createWriter(fileDest, level, fileFolderDestination, mode, fileSuffixIfFull, messageOptions);
+      auto expected = writer;
 
-      mModuleDest.insert(module, log);
+      if (slot.compare_exchange_strong(expected, nullptr))
+         return;
+   }
+}
 
-      startWriter(module, log, mode, notify);
+/**
+ * @brief The fatal signals handled by installCrashHandler, and the handlers installed before it, that are called once
+ * the data has been dumped.
+ */
+const int crashSignals[] = {
+   SIGSEGV,
+   SIGABRT,
+#ifdef SIGBUS
+   SIGBUS,
+#endif
+   SIGFPE,
+   SIGILL,
+};
+constexpr auto CrashSignalCount = static_cast<int>(sizeof(crashSignals) / sizeof(crashSignals[0]));
+std::atomic<bool> crashHandlerInstalled { false };
+
+#ifdef Q_OS_WIN
+using CrashHandlerFunction = void (*)(int);
+CrashHandlerFunction previousCrashHandlers[CrashSignalCount];
+#else
+struct sigaction previousCrashActions[CrashSignalCount];
+#endif
+
+void dumpCrashWriters()
+{
+   for (auto &slot : crashWriters)
+   {
+      if (const auto writer = slot.load(std::memory_order_acquire))
+         writer->dumpPendingData();
+   }
+}
 
-      return true;
+#ifdef Q_OS_WIN
+void crashHandler(int signal)
+{
+   dumpCrashWriters();
+
+   auto index = 0;
+
+   while (index < CrashSignalCount && crashSignals[index] != signal)
+      ++index;
+
+   const auto previous = index < CrashSignalCount ? previousCrashHandlers[index] : SIG_DFL;
+
+   // The handler of the application gets the signal next, otherwise the default action ends the process
+   if (previous != SIG_DFL && previous != SIG_IGN && previous != SIG_ERR)
+   {
+      std::signal(signal, previous);
+      previous(signal);
+      return;
    }
 
-   return false;
+   std::signal(signal, SIG_DFL);
+   std::raise(signal);
+}
+#else
+void crashHandler(int signal, siginfo_t *info, void *context)
+{
+   dumpCrashWriters();
+
+   auto index = 0;
+
+   while (index < CrashSignalCount && crashSignals[index] != signal)
+      ++index;
+
+   if (index < CrashSignalCount)
+   {
+      const auto &previous = previousCrashActions[index];
+
+      // The handler of the application, or of another crash reporter, gets the signal with its original details
+      if ((previous.sa_flags & SA_SIGINFO) && previous.sa_sigaction)
+      {
+         previous.sa_sigaction(signal, info, context);
+         return;
+      }
+
+      if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+      {
+         previous.sa_handler(signal);
+         return;
+      }
+   }
+
+   // The default action produces the core dump or the usual exit code
+   struct sigaction defaultAction {};
+   defaultAction.sa_handler = SIG_DFL;
+   sigemptyset(&defaultAction.sa_mask);
+   sigaction(signal, &defaultAction, nullptr);
+
+   raise(signal);
+}
+#endif
+
+/**
+ * @brief Sets the time and the thread of a record that is about to be queued.
+ * @param record The record to fill.
+ */
+void stampRecord(LogRecord &record)
+{
+   record.timestamp = LogRecord::currentTimestamp();
+   record.threadId = currentThreadId();
+}
+}
+
+class QLoggerManager::SuppressionReporter : public QThread
+{
+public:
+   explicit SuppressionReporter(QLoggerManager *manager)
+      : mManager(manager)
+   {
+   }
+
+   void run() override { mManager->runSuppressionReports(); }
+
+private:
+   QLoggerManager *mManager;
+};
+
+QLoggerManager *QLoggerManager::getInstance()
+{
+   static QLoggerManager INSTANCE;
+
+   return &INSTANCE;
+}
+
+bool QLoggerManager::addDestination(const QString &fileDest, const QString &module, LogLevel level,
+                                    const QString &fileFolderDestination, LogMode mode, LogFileDisplay fileSuffixIfFull,
+                                    LogMessageDisplays messageOptions, bool notify)
+{
+   return addDestination(fileDest, QStringList { module }, level, fileFolderDestination, mode, fileSuffixIfFull,
+                         messageOptions, notify);
 }
 
 bool QLoggerManager::addDestination(const QString &fileDest, const QStringList &modules, LogLevel level,
@@ -54,12 +238,22 @@ bool QLoggerManager::addDestination(const QString &fileDest, const QStringList &
 {
    QMutexLocker lock(&mMutex);
    bool allAdded = false;
+   QLoggerWriter *log = nullptr;
 
    for (const auto &module : modules)
    {
       if (!mModuleDest.contains(module))
       {
-         const auto log = createWriter(fileDest, level, fileFolderDestination, mode, fileSuffixIfFull, messageOptions);
+         // Modules logging into the same file share the writer, its queue and its file. The destination path is
+         // only resolved once for all the modules.
+         if (!log)
+            log = findWriter(fileDest, fileFolderDestination);
+
+         if (!log)
+         {
+            log = createWriter(fileDest, level, fileFolderDestination, mode, fileSuffixIfFull, messageOptions);
+            mWriters.append(log);
+         }
 
          mModuleDest.insert(module, log);
 
@@ -69,12 +263,32 @@ bool QLoggerManager::addDestination(const QString &fileDest, const QStringList &
       }
    }
 
+   if (allAdded)
+      publishWriters();
+
    return allAdded;
 }
 
+QLoggerWriter *QLoggerManager::findWriter(const QString &fileDest, const QString &fileFolderDestination) const
+{
+   const auto lFileDest = fileDest.isEmpty() ? mDefaultFileDestination : fileDest;
+   const auto lFileFolderDestination = fileFolderDestination.isEmpty()
+       ? mDefaultFileDestinationFolder
+       : QDir::fromNativeSeparators(fileFolderDestination);
+   const auto destination = QLoggerWriter::resolveFileDestination(lFileDest, lFileFolderDestination);
+
+   for (const auto log : mWriters)
+   {
+      if (log->getFileDestination() == destination)
+         return log;
+   }
+
+   return nullptr;
+}
+
 QLoggerWriter *QLoggerManager::createWriter(const QString &fileDest, LogLevel level,
                                             const QString &fileFolderDestination, LogMode mode,
-                                            LogFileDisplay fileSuffixIfFull, LogMessageDisplays messageOptions) const
+                                            LogFileDisplay fileSuffixIfFull, LogMessageDisplays messageOptions)
 {
    const auto lFileDest = fileDest.isEmpty() ? mDefaultFileDestination : fileDest;
    const auto lLevel = level == LogLevel::Warning ? mDefaultLevel : level;
@@ -91,21 +305,144 @@ QLoggerWriter *QLoggerManager::createWriter(const QString &fileDest, LogLevel le
        = new QLoggerWriter(lFileDest, lLevel, lFileFolderDestination, lMode, lFileSuffixIfFull, lMessageOptions);
 
    log->setMaxFileSize(mDefaultMaxFileSize);
+   log->setTimestampFormat(mDefaultTimestampFormat);
+   log->setConsoleOptions(mDefaultConsoleOptions);
+   log->setFileAccess(mDefaultFileAccess);
+   log->setFileFormat(mDefaultFileFormat);
+   log->setCompression(mDefaultCompression);
+   log->setRetention(mDefaultRetentionMaxFiles, mDefaultRetentionMaxTotalSize, mDefaultRetentionMaxAgeDays);
+   log->setFlushPolicy(mDefaultFlushSize, mDefaultFlushInterval);
+   log->setWakePolicy(mDefaultWakeBatchSize, mDefaultMaxWakeLatency);
+   log->setQueueCapacity(mDefaultQueueCapacity, mDefaultQueuePolicy, mDefaultDropLevel);
+   log->setFsyncPolicy(mDefaultFsyncPolicy, mDefaultFsyncInterval);
+   log->setMemoryCapacity(mDefaultMemoryCapacity);
+   log->setIndexInterval(mDefaultIndexInterval);
    log->stop(mIsStop);
 
+   registerCrashWriter(log);
+
+   if (mWriterThreadPoolSize > 0)
+   {
+      if (!mWorkerPool)
+         mWorkerPool = new QLoggerWorkerPool(mWriterThreadPoolSize);
+
+      log->setWorkerPool(mWorkerPool);
+      mWorkerPool->addWriter(log);
+   }
+
    return log;
 }
 
 void QLoggerManager::startWriter(const QString &module, QLoggerWriter *log, LogMode mode, bool notify)
 {
+   // Started first, so the messages logged before the destination are drained while they are queued
+   if (mode != LogMode::Disabled && !log->getWorkerPool())
+      log->start();
+
    if (notify)
    {
-      const auto threadId = QString("%1").arg((quintptr)QThread::currentThread(), QT_POINTER_SIZE * 2, 16, QChar('0'));
-      log->enqueue(QDateTime::currentDateTime(), threadId, module, LogLevel::Info, "", "", -1, "Adding destination!");
+      LogRecord record;
+      record.level = LogLevel::Info;
+      record.module = module;
+      record.message = QStringLiteral("Adding destination!");
+      stampRecord(record);
+
+      log->enqueue(std::move(record), false);
    }
 
-   if (mode != LogMode::Disabled)
-      log->start();
+   writeAndDequeueMessages(module);
+}
+
+void QLoggerManager::publishWriters()
+{
+   for (auto iter = mModuleDest.constBegin(); iter != mModuleDest.constEnd(); ++iter)
+   {
+      auto entry = mModuleEntries.value(iter.key(), nullptr);
+
+      if (!entry)
+      {
+         entry = new ModuleEntry();
+         entry->name = iter.key();
+
+         mModuleEntries.insert(iter.key(), entry);
+      }
+   }
+
+   updateEnabledLevels();
+
+   // The writers are set once the levels are known, so a handle in use never sees a writer with the default level
+   for (auto iter = mModuleDest.constBegin(); iter != mModuleDest.constEnd(); ++iter)
+      mModuleEntries.value(iter.key())->writer.store(iter.value(), std::memory_order_release);
+
+   const auto snapshot = new ModuleSnapshot(mModuleEntries);
+
+   mRetiredSnapshots.append(mModuleSnapshot.exchange(snapshot, std::memory_order_acq_rel));
+}
+
+void QLoggerManager::updateEnabledLevels()
+{
+   static const auto DisabledLevel = static_cast<int>(LogLevel::Fatal) + 1;
+
+   for (auto iter = mModuleEntries.constBegin(); iter != mModuleEntries.constEnd(); ++iter)
+   {
+      const auto entry = iter.value();
+      const auto writer = mModuleDest.value(iter.key(), nullptr);
+
+      // The handles of modules without destination keep all their messages until it is added
+      if (!writer)
+         continue;
+
+      const auto isLogEnabled = writer->getMode() != LogMode::Disabled && !writer->isStop();
+      const auto level = resolveModuleLevel(iter.key(), writer);
+
+      entry->enabledLevel.store(isLogEnabled ? static_cast<int>(level) : DisabledLevel, std::memory_order_relaxed);
+
+      const auto sampling = mModuleSampling.value(iter.key());
+      const auto threshold = qRound64(qBound(0.0, sampling.rate, 1.0) * static_cast<double>(Q_UINT64_C(1) << 32));
+
+      entry->sampleThreshold.store(static_cast<quint64>(threshold), std::memory_order_relaxed);
+      entry->sampleMaxLevel.store(static_cast<int>(sampling.maxLevel), std::memory_order_relaxed);
+   }
+}
+
+LogLevel QLoggerManager::resolveModuleLevel(const QString &module, const QLoggerWriter *writer) const
+{
+   if (!mModuleLevels.isEmpty())
+   {
+      auto name = module;
+
+      // From the module itself up to its root: "net.http.client", "net.http" and "net"
+      while (!name.isEmpty())
+      {
+         const auto iter = mModuleLevels.constFind(name);
+
+         if (iter != mModuleLevels.constEnd())
+            return iter.value();
+
+         const auto dot = name.lastIndexOf(QLatin1Char('.'));
+
+         name.truncate(dot < 0 ? 0 : dot);
+      }
+   }
+
+   return writer->getLevel();
+}
+
+void QLoggerManager::setModuleLevel(const QString &module, LogLevel level)
+{
+   QMutexLocker lock(&mMutex);
+
+   mModuleLevels.insert(module, level);
+
+   updateEnabledLevels();
+}
+
+void QLoggerManager::clearModuleLevel(const QString &module)
+{
+   QMutexLocker lock(&mMutex);
+
+   if (mModuleLevels.remove(module) > 0)
+      updateEnabledLevels();
 }
 
 void QLoggerManager::clearFileDestinationFolder(const QString &fileFolderDestination, int days)
@@ -130,6 +467,63 @@ void QLoggerManager::clearFileDestinationFolder(const QString &fileFolderDestina
    }
 }
 
+bool QLoggerManager::addSink(const QString &module, QLoggerSink *sink)
+{
+   QMutexLocker lock(&mMutex);
+
+   const auto log = mModuleDest.value(module, nullptr);
+
+   if (!log || !sink)
+      return false;
+
+   log->addSink(sink);
+
+   return true;
+}
+
+QVector<WriterStatistics> QLoggerManager::getStatistics() const
+{
+   QMutexLocker lock(&mMutex);
+
+   QVector<WriterStatistics> statistics;
+   statistics.reserve(mWriters.count());
+
+   for (const auto log : mWriters)
+   {
+      auto writerStatistics = log->getStatistics();
+
+      for (auto iter = mModuleDest.constBegin(); iter != mModuleDest.constEnd(); ++iter)
+      {
+         if (iter.value() == log)
+            writerStatistics.modules.append(iter.key());
+      }
+
+      statistics.append(writerStatistics);
+   }
+
+   return statistics;
+}
+
+void QLoggerManager::setThreadName(const QString &name)
+{
+   // An empty name is replaced by the default identifier the next time it is used
+   currentThreadId() = name;
+}
+
+void QLoggerManager::setNonWriterQueueLimit(int limit)
+{
+   QMutexLocker lock(&mMutex);
+
+   mNonWriterQueueLimit = limit;
+}
+
+void QLoggerManager::setWriterThreadPoolSize(int size)
+{
+   QMutexLocker lock(&mMutex);
+
+   mWriterThreadPoolSize = size;
+}
+
 void QLoggerManager::setDefaultFileDestinationFolder(const QString &fileDestinationFolder)
 {
    mDefaultFileDestinationFolder = QDir::fromNativeSeparators(fileDestinationFolder);
@@ -141,55 +535,334 @@ void QLoggerManager::writeAndDequeueMessages(const QString &module)
 
    const auto logWriter = mModuleDest.value(module, nullptr);
 
-   if (logWriter && !logWriter->isStop())
+   if (!logWriter || logWriter->isStop() || !mNonWriterQueue.contains(module))
+      return;
+
+   auto records = mNonWriterQueue.take(module);
+   const auto level = resolveModuleLevel(module, logWriter);
+
+   for (auto &record : records)
    {
-      const auto values = mNonWriterQueue.values(module);
+      // The manager is locked, so the backlog is queued beyond the capacity instead of waiting for room
+      if (level <= record.level)
+         logWriter->enqueue(std::move(record), false);
+   }
+}
+
+void QLoggerManager::enqueueMessage(const QString &module, LogLevel level, QString message, const QString &function,
+                                    const QString &file, int line)
+{
+   LogRecord record;
+   record.level = level;
+   record.line = line;
+   record.functionName = function;
+   record.fileName = file;
+   record.module = module;
+   record.message = std::move(message);
+
+   enqueueRecord(std::move(record));
+}
+
+void QLoggerManager::enqueueMessage(const QString &module, LogLevel level, QString message, const char *function,
+                                    const char *file, int line)
+{
+   LogRecord record;
+   record.level = level;
+   record.line = line;
+   record.function = function;
+   record.file = file;
+   record.module = module;
+   record.message = std::move(message);
+
+   enqueueRecord(std::move(record));
+}
+
+void QLoggerManager::enqueueMessage(const QString &module, LogLevel level, QString message, QVector<LogField> fields,
+                                    const char *function, const char *file, int line)
+{
+   LogRecord record;
+   record.level = level;
+   record.line = line;
+   record.function = function;
+   record.file = file;
+   record.module = module;
+   record.message = std::move(message);
+   record.fields = std::move(fields);
+
+   enqueueRecord(std::move(record));
+}
+
+void QLoggerManager::enqueueRecord(LogRecord &&record)
+{
+   enqueueRecord(mModuleSnapshot.load(std::memory_order_acquire)->value(record.module, nullptr), std::move(record));
+}
+
+void QLoggerManager::enqueueRecord(const ModuleEntry *entry, LogRecord &&record)
+{
+   const auto writer = entry ? entry->writer.load(std::memory_order_acquire) : nullptr;
+
+   if (!writer)
+      enqueueNonWriterMessage(std::move(record));
+   else if (static_cast<int>(record.level) >= entry->enabledLevel.load(std::memory_order_relaxed))
+   {
+      const auto isFatal = record.level == LogLevel::Fatal;
+
+      stampRecord(record);
+
+      writer->enqueue(std::move(record));
+
+      // The process is likely to end after a fatal message, so it waits until the message reaches the file
+      if (isFatal)
+         writer->flush(FatalFlushTimeout);
+   }
+}
+
+QLoggerModule QLoggerManager::module(const QString &name)
+{
+   QMutexLocker lock(&mMutex);
+
+   auto entry = mModuleEntries.value(name, nullptr);
+
+   // The entry gets its writer when the destination of the module is added
+   if (!entry)
+   {
+      entry = new ModuleEntry();
+      entry->name = name;
+
+      mModuleEntries.insert(name, entry);
+   }
+
+   return QLoggerModule(entry);
+}
+
+void QLoggerManager::enqueueMessage(QLoggerModule module, LogLevel level, QString message, const char *function,
+                                    const char *file, int line)
+{
+   LogRecord record;
+   record.level = level;
+   record.line = line;
+   record.function = function;
+   record.file = file;
+   record.module = module.name();
+   record.message = std::move(message);
+
+   enqueueRecord(module.mEntry, std::move(record));
+}
+
+void QLoggerManager::enqueueMessage(QLoggerModule module, LogLevel level, QString message, QVector<LogField> fields,
+                                    const char *function, const char *file, int line)
+{
+   LogRecord record;
+   record.level = level;
+   record.line = line;
+   record.function = function;
+   record.file = file;
+   record.module = module.name();
+   record.message = std::move(message);
+   record.fields = std::move(fields);
+
+   enqueueRecord(module.mEntry, std::move(record));
+}
+
+bool QLoggerManager::flush(int timeout)
+{
+   QMutexLocker lock(&mMutex);
+   const auto writers = mWriters;
+   lock.unlock();
+
+   const QDeadlineTimer deadline(timeout);
+   auto flushed = true;
+
+   for (const auto writer : writers)
+   {
+      const auto remaining = deadline.isForever() ? -1 : static_cast<int>(qMax<qint64>(0, deadline.remainingTime()));
+
+      flushed = writer->flush(remaining) && flushed;
+   }
+
+   return flushed;
+}
+
+bool QLoggerManager::dumpMemory(int timeout)
+{
+   QMutexLocker lock(&mMutex);
+   const auto writers = mWriters;
+   lock.unlock();
+
+   const QDeadlineTimer deadline(timeout);
+   auto dumped = true;
+
+   for (const auto writer : writers)
+   {
+      if (writer->getMode() != LogMode::Memory)
+         continue;
+
+      const auto remaining = deadline.isForever() ? -1 : static_cast<int>(qMax<qint64>(0, deadline.remainingTime()));
+
+      dumped = writer->dumpMemory(remaining) && dumped;
+   }
+
+   return dumped;
+}
 
-      for (const auto &vals : values)
+void QLoggerManager::installCrashHandler()
+{
+   // Installing it twice would save the handler itself as the previous one
+   if (crashHandlerInstalled.exchange(true))
+      return;
+
+   for (auto i = 0; i < CrashSignalCount; ++i)
+   {
+#ifdef Q_OS_WIN
+      previousCrashHandlers[i] = std::signal(crashSignals[i], crashHandler);
+#else
+      struct sigaction action {};
+      action.sa_sigaction = crashHandler;
+      action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+      sigemptyset(&action.sa_mask);
+
+      sigaction(crashSignals[i], &action, &previousCrashActions[i]);
+#endif
+   }
+}
+
+bool QLoggerManager::isEnabled(const QString &module, LogLevel level) const
+{
+   const auto entry = mModuleSnapshot.load(std::memory_order_acquire)->value(module, nullptr);
+
+   return !entry || static_cast<int>(level) >= entry->enabledLevel.load(std::memory_order_relaxed);
+}
+
+bool QLoggerManager::shouldLog(const QString &module, LogLevel level) const
+{
+   return shouldLog(mModuleSnapshot.load(std::memory_order_acquire)->value(module, nullptr), level);
+}
+
+bool QLoggerManager::shouldLog(const ModuleEntry *entry, LogLevel level) const
+{
+   // The entry of a handle has no writer until the destination is added, its level and its sampling keep all
+   if (!entry)
+      return true;
+
+   if (static_cast<int>(level) < entry->enabledLevel.load(std::memory_order_relaxed))
+      return false;
+
+   const auto threshold = entry->sampleThreshold.load(std::memory_order_relaxed);
+
+   return threshold > std::numeric_limits<quint32>::max()
+       || static_cast<int>(level) > entry->sampleMaxLevel.load(std::memory_order_relaxed)
+       || nextRandom() < threshold;
+}
+
+void QLoggerManager::setModuleSampling(const QString &module, double rate, LogLevel maxLevel)
+{
+   QMutexLocker lock(&mMutex);
+
+   mModuleSampling.insert(module, { rate, maxLevel });
+
+   updateEnabledLevels();
+}
+
+void QLoggerManager::setCallSiteRateLimit(int messagesPerSecond, int burst)
+{
+   mCallSiteBurst.store(qMax(1, burst), std::memory_order_relaxed);
+   mCallSiteInterval.store(messagesPerSecond > 0 ? 1000 * 1000 * 1000LL / messagesPerSecond : 0,
+                           std::memory_order_relaxed);
+}
+
+bool QLoggerManager::acquireLimitedCallSite(QLoggerRateLimiter &limiter, const QString &module, LogLevel level,
+                                            const char *function, const char *file, int line)
+{
+   const auto interval = mCallSiteInterval.load(std::memory_order_relaxed);
+   quint64 suppressed = 0;
+
+   if (interval > 0
+       && !limiter.tryAcquire(LogRecord::currentTimestamp(), interval,
+                              mCallSiteBurst.load(std::memory_order_relaxed), suppressed))
+   {
+      // Only the first refusal since the last report registers the call site, the others are a single increment
+      if (limiter.markPending())
       {
-         const auto level = qvariant_cast<LogLevel>(vals.at(2).toInt());
+         QMutexLocker lock(&mSuppressedMutex);
 
-         if (logWriter->getLevel() <= level)
+         mSuppressedCallSites.append({ &limiter, module, level, function, file, line });
+
+         if (!mSuppressionReporter && !mSuppressionQuit)
          {
-            const auto datetime = vals.at(0).toDateTime();
-            const auto threadId = vals.at(1).toString();
-            const auto function = vals.at(3).toString();
-            const auto file = vals.at(4).toString();
-            const auto line = vals.at(5).toInt();
-            const auto message = vals.at(6).toString();
-
-            logWriter->enqueue(datetime, threadId, module, level, function, file, line, message);
+            mSuppressionReporter = new SuppressionReporter(this);
+            mSuppressionReporter->setObjectName("QLoggerSuppressionReporter");
+            mSuppressionReporter->start();
          }
       }
 
-      mNonWriterQueue.remove(module);
+      return false;
+   }
+
+   if (suppressed > 0)
+   {
+      enqueueMessage(module, level, QString("Suppressed %1 similar messages").arg(suppressed), function, file,
+                     line);
    }
+
+   return true;
 }
 
-void QLoggerManager::enqueueMessage(const QString &module, LogLevel level, const QString &message,
-                                    const QString &function, const QString &file, int line)
+void QLoggerManager::reportSuppressedMessages()
 {
-   QMutexLocker lock(&mMutex);
-   const auto logWriter = mModuleDest.value(module, nullptr);
-   const auto isLogEnabled = logWriter && logWriter->getMode() != LogMode::Disabled && !logWriter->isStop();
+   QVector<SuppressedCallSite> callSites;
 
-   if (isLogEnabled && logWriter->getLevel() <= level)
    {
-      const auto threadId = QString("%1").arg((quintptr)QThread::currentThread(), QT_POINTER_SIZE * 2, 16, QChar('0'));
-      const auto fileName = file.mid(file.lastIndexOf('/') + 1);
+      QMutexLocker lock(&mSuppressedMutex);
+      callSites.swap(mSuppressedCallSites);
+   }
 
-      writeAndDequeueMessages(module);
+   for (const auto &callSite : std::as_const(callSites))
+   {
+      // Zero if the call site has logged again since, and reported them with its message
+      const auto suppressed = callSite.limiter->takeSuppressed();
+
+      if (suppressed > 0)
+      {
+         enqueueMessage(callSite.module, callSite.level, QString("Suppressed %1 similar messages").arg(suppressed),
+                        callSite.function, callSite.file, callSite.line);
+      }
+   }
+}
+
+void QLoggerManager::runSuppressionReports()
+{
+   QMutexLocker lock(&mSuppressedMutex);
 
-      logWriter->enqueue(QDateTime::currentDateTime(), threadId, module, level, function, fileName, line, message);
+   while (!mSuppressionQuit)
+   {
+      mSuppressionWake.wait(&mSuppressedMutex, SuppressionReportInterval);
+
+      lock.unlock();
+      reportSuppressedMessages();
+      lock.relock();
+   }
+}
+
+void QLoggerManager::enqueueNonWriterMessage(LogRecord &&record)
+{
+   QMutexLocker lock(&mMutex);
+
+   // The destination could have been added while waiting for the lock
+   if (mModuleDest.contains(record.module))
+   {
+      lock.unlock();
+      enqueueRecord(std::move(record));
    }
-   else if (!logWriter && mNonWriterQueue.count(module) < QUEUE_LIMIT)
+   else
    {
-      const auto threadId = QString("%1").arg((quintptr)QThread::currentThread(), QT_POINTER_SIZE * 2, 16, QChar('0'));
-      const auto fileName = file.mid(file.lastIndexOf('/') + 1);
+      // The literals of the macros are kept as they are, the records are stored without any conversion
+      auto &records = mNonWriterQueue[record.module];
 
-      mNonWriterQueue.insert(module,
-                             { QDateTime::currentDateTime(), threadId, QVariant::fromValue<LogLevel>(level), function,
-                               fileName, line, message });
+      if (records.count() < mNonWriterQueueLimit)
+      {
+         stampRecord(record);
+         records.append(std::move(record));
+      }
    }
 }
 
@@ -199,8 +872,10 @@ void QLoggerManager::pause()
 
    mIsStop = true;
 
-   for (auto &logWriter : mModuleDest)
+   for (auto &logWriter : mWriters)
       logWriter->stop(mIsStop);
+
+   updateEnabledLevels();
 }
 
 void QLoggerManager::resume()
@@ -209,8 +884,14 @@ void QLoggerManager::resume()
 
    mIsStop = false;
 
-   for (auto &logWriter : mModuleDest)
+   for (auto &logWriter : mWriters)
       logWriter->stop(mIsStop);
+
+   updateEnabledLevels();
+
+   // Messages logged before their destination was added are kept while paused
+   for (const auto &module : mNonWriterQueue.keys())
+      writeAndDequeueMessages(module);
 }
 
 void QLoggerManager::overwriteLogMode(LogMode mode)
@@ -219,8 +900,10 @@ void QLoggerManager::overwriteLogMode(LogMode mode)
 
    setDefaultMode(mode);
 
-   for (auto &logWriter : mModuleDest)
+   for (auto &logWriter : mWriters)
       logWriter->setLogMode(mode);
+
+   updateEnabledLevels();
 }
 
 void QLoggerManager::overwriteLogLevel(LogLevel level)
@@ -229,8 +912,10 @@ void QLoggerManager::overwriteLogLevel(LogLevel level)
 
    setDefaultLevel(level);
 
-   for (auto &logWriter : mModuleDest)
+   for (auto &logWriter : mWriters)
       logWriter->setLogLevel(level);
+
+   updateEnabledLevels();
 }
 
 void QLoggerManager::overwriteMaxFileSize(int maxSize)
@@ -239,32 +924,65 @@ void QLoggerManager::overwriteMaxFileSize(int maxSize)
 
    setDefaultMaxFileSize(maxSize);
 
-   for (auto &logWriter : mModuleDest)
+   for (auto &logWriter : mWriters)
       logWriter->setMaxFileSize(maxSize);
 }
 
 QLoggerManager::~QLoggerManager()
 {
+   // The reporter logs through the manager, so it is stopped before the manager is locked
+   {
+      QMutexLocker lock(&mSuppressedMutex);
+      mSuppressionQuit = true;
+      mSuppressionWake.wakeAll();
+   }
+
+   if (mSuppressionReporter)
+   {
+      mSuppressionReporter->wait();
+      delete mSuppressionReporter;
+      mSuppressionReporter = nullptr;
+   }
+
+   reportSuppressedMessages();
+
    QMutexLocker locker(&mMutex);
 
-   for (const auto &dest : mModuleDest.toStdMap())
-      writeAndDequeueMessages(dest.first);
+   for (const auto &module : mNonWriterQueue.keys())
+      writeAndDequeueMessages(module);
+
+   // The pool is stopped first so the writers can close their files from this thread
+   if (mWorkerPool)
+      mWorkerPool->stop();
 
    QVector<QString> oldFiles;
 
-   for (auto dest : std::as_const(mModuleDest))
+   for (auto dest : std::as_const(mWriters))
    {
+      unregisterCrashWriter(dest);
       dest->closeDestination();
       dest->wait();
 
-      oldFiles.append(dest->getFileDestinationFolder());
+      if (!oldFiles.contains(dest->getFileDestinationFolder()))
+         oldFiles.append(dest->getFileDestinationFolder());
    }
 
-   for (auto dest : std::as_const(mModuleDest))
-      delete dest;
+   qDeleteAll(mWriters);
+   mWriters.clear();
+
+   delete mWorkerPool;
+   mWorkerPool = nullptr;
 
    mModuleDest.clear();
 
+   delete mModuleSnapshot.exchange(nullptr);
+
+   qDeleteAll(mModuleEntries);
+   mModuleEntries.clear();
+
+   qDeleteAll(mRetiredSnapshots);
+   mRetiredSnapshots.clear();
+
    if (!mNewLogsFolder.isEmpty() && mNewLogsFolder != mDefaultFileDestinationFolder)
    {
       for (const auto &oldDestination : oldFiles)
@@ -23,15 +23,104 @@
  ***************************************************************************************/
 
 #include <QLoggerLevel.h>
+#include <QLoggerRateLimiter.h>
+#include <QLoggerRecord.h>
+#include <QLoggerStatistics.h>
 
 #include <QMutex>
 #include <QMap>
-#include <QVariant>
+#include <QHash>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+
+/**
+ * @brief Minimum level compiled in the QLog_* macros: 0 Trace, 1 Debug, 2 Info, 3 Warning, 4 Error, 5 Fatal. The calls
+ * below it are removed from the binary, their arguments are not even evaluated. It can be set from QLogger.pri with
+ * the QLOGGER_MIN_LEVEL qmake variable.
+ */
+#ifndef QLOGGER_MIN_LEVEL
+#   define QLOGGER_MIN_LEVEL 0
+#endif
 
 namespace QLogger
 {
 
+class QLoggerSink;
 class QLoggerWriter;
+class QLoggerWorkerPool;
+
+/**
+ * @brief The QLoggerModuleEntry struct holds the state of a module read by the logging threads without locking. It
+ * is internal to QLoggerManager, and lives as long as the manager.
+ */
+struct QLoggerModuleEntry
+{
+   QString name;
+   /**
+    * @brief The writer of the module, null until the destination of the module is added.
+    */
+   std::atomic<QLoggerWriter *> writer { nullptr };
+   /**
+    * @brief Lowest level that is logged. It folds the writer level, the overrides, the mode and the paused state into
+    * a single value so the filtering is one load.
+    */
+   std::atomic<int> enabledLevel { 0 };
+   /**
+    * @brief A message is kept by the sampling if a random 32 bits number is lower than the threshold. 2^32 keeps all
+    * the messages.
+    */
+   std::atomic<quint64> sampleThreshold { Q_UINT64_C(1) << 32 };
+   std::atomic<int> sampleMaxLevel { static_cast<int>(LogLevel::Info) };
+};
+
+/**
+ * @brief The QLoggerModule class is a handle of a module, got once with QLoggerManager::module. The QLog_* macros
+ * accept it instead of the name of the module: logging with it reads the writer and the level of the module without
+ * looking the name up.
+ *
+ * It is a pointer that can be copied freely, and stays valid as long as the manager.
+ */
+class QLoggerModule
+{
+public:
+   QLoggerModule() = default;
+
+   /**
+    * @brief isValid Checks if the handle refers to a module.
+    */
+   bool isValid() const { return mEntry != nullptr; }
+
+   /**
+    * @brief name Gets the name of the module.
+    */
+   QString name() const { return mEntry ? mEntry->name : QString(); }
+
+private:
+   friend class QLoggerManager;
+
+   explicit QLoggerModule(const QLoggerModuleEntry *entry)
+      : mEntry(entry)
+   {
+   }
+
+   const QLoggerModuleEntry *mEntry = nullptr;
+};
+
+/**
+ * @brief moduleArgument Evaluates the module given to a QLog_* macro once, as a handle or as a name, so a literal is
+ * only converted to a QString once per call.
+ */
+inline QLoggerModule moduleArgument(QLoggerModule module)
+{
+   return module;
+}
+
+inline QString moduleArgument(QString module)
+{
+   return module;
+}
 
 /**
  * @brief The QLoggerManager class manages the different destination files that we would like to have.
@@ -68,7 +157,8 @@ public:
     * @brief This method creates a QLoogerWriter that stores the name of the file and the log
     * level assigned to it. Here is added to the map the different modules assigned to each
     * log file. The method returns <em>false</em> if a module is configured to be stored in
-    * more than one file.
+    * more than one file. Modules stored in the same file share one QLoogerWriter: if the file has already a
+    * writer, its configuration is kept.
     *
     * @param fileDest The file name and path to print logs.
     * @param modules The modules that will be stored in the file.
@@ -89,10 +179,14 @@ public:
     * @param fileFolderDestination The destination folder.
     * @param days Minimum age of log files to delete. Logs older than
     *        this value will be removed. If days is -1, deletes any log file.
+    *
+    * @note It blocks until all the files are checked. setDefaultRetention removes the old rotated files in the
+    * background instead.
     */
    static void clearFileDestinationFolder(const QString &fileFolderDestination, int days = -1);
    /**
-    * @brief enqueueMessage Enqueues a message in the corresponding QLoggerWritter.
+    * @brief enqueueMessage Enqueues a message in the corresponding QLoggerWritter. Once the module has a
+    * destination this method is lock-free: the writer is looked up in a read-only snapshot of the destinations.
     * @param module The module that writes the message.
     * @param level The level of the message.
     * @param message The message to log.
@@ -100,8 +194,241 @@ public:
     * @param file The file that logs.
     * @param line The line in the file where the log comes from.
     */
-   void enqueueMessage(const QString &module, LogLevel level, const QString &message, const QString &function,
+   void enqueueMessage(const QString &module, LogLevel level, QString message, const QString &function,
                        const QString &file, int line);
+   /**
+    * @brief enqueueMessage Enqueues a message in the corresponding QLoggerWritter. Used by the QLog_* macros: the
+    * function and the file are static literals that are only converted by the writer thread, and only if the layout
+    * has them.
+    * @param module The module that writes the message.
+    * @param level The level of the message.
+    * @param message The message to log. A temporary is moved into the record instead of being copied.
+    * @param function The function in the file where the log comes from.
+    * @param file The file that logs, stripped of its path by the macros at compile time.
+    * @param line The line in the file where the log comes from.
+    */
+   void enqueueMessage(const QString &module, LogLevel level, QString message, const char *function, const char *file,
+                       int line);
+   /**
+    * @brief enqueueMessage Version of enqueueMessage for a message given as a view. The record outlives the call, so
+    * the view is copied once into the record.
+    */
+   void enqueueMessage(const QString &module, LogLevel level, QStringView message, const char *function,
+                       const char *file, int line)
+   {
+      enqueueMessage(module, level, message.toString(), function, file, line);
+   }
+   /**
+    * @brief module Gets the handle of a module, to log into it without looking its name up. The module does not need
+    * a destination yet: its messages are kept until the destination is added, as with its name.
+    * @param name The name of the module.
+    * @return The handle, valid as long as the manager.
+    */
+   QLoggerModule module(const QString &name);
+
+   /**
+    * @brief enqueueMessage Version of enqueueMessage for a module handle, used by the QLog_* macros.
+    */
+   void enqueueMessage(QLoggerModule module, LogLevel level, QString message, const char *function, const char *file,
+                       int line);
+   void enqueueMessage(QLoggerModule module, LogLevel level, QStringView message, const char *function,
+                       const char *file, int line)
+   {
+      enqueueMessage(module, level, message.toString(), function, file, line);
+   }
+   void enqueueMessage(QLoggerModule module, LogLevel level, QString message, QVector<LogField> fields,
+                       const char *function, const char *file, int line);
+
+   /**
+    * @brief enqueueMessage Enqueues a message with typed key/value fields in the corresponding QLoggerWritter. Used
+    * by the QLog_*Fields macros: the fields are not converted to text by the logging thread.
+    * @param module The module that writes the message.
+    * @param level The level of the message.
+    * @param message The message to log.
+    * @param fields The key/values of the message.
+    * @param function The function in the file where the log comes from.
+    * @param file The file that logs.
+    * @param line The line in the file where the log comes from.
+    */
+   void enqueueMessage(const QString &module, LogLevel level, QString message, QVector<LogField> fields,
+                       const char *function, const char *file, int line);
+
+   /**
+    * @brief isEnabled Checks if a message of the given level would be logged for the module. It is lock-free and
+    * used by the QLog_* macros to avoid building messages that will be filtered out. Modules without destination
+    * are always enabled since their messages are kept until the destination is added.
+    *
+    * @param module The module that writes the message.
+    * @param level The level of the message.
+    * @return True if the message would be logged, otherwise false.
+    */
+   bool isEnabled(const QString &module, LogLevel level) const;
+
+   /**
+    * @brief isEnabled Version of isEnabled for a level known at compile time, used by the QLog_* macros. Levels
+    * stripped by QLOGGER_MIN_LEVEL are folded to false by the compiler.
+    *
+    * @param module The module that writes the message.
+    * @return True if the message would be logged, otherwise false.
+    */
+   template<LogLevel Level>
+   bool isEnabled(const QString &module) const
+   {
+      return static_cast<int>(Level) >= QLOGGER_MIN_LEVEL && isEnabled(module, Level);
+   }
+
+   /**
+    * @brief isEnabled Versions of isEnabled for a module handle.
+    */
+   bool isEnabled(QLoggerModule module, LogLevel level) const
+   {
+      return !module.mEntry || static_cast<int>(level) >= module.mEntry->enabledLevel.load(std::memory_order_relaxed);
+   }
+
+   template<LogLevel Level>
+   bool isEnabled(QLoggerModule module) const
+   {
+      return static_cast<int>(Level) >= QLOGGER_MIN_LEVEL && isEnabled(module, Level);
+   }
+
+   /**
+    * @brief shouldLog Checks if a message of the given level is logged for the module, applying the sampling of the
+    * module on top of isEnabled. It is lock-free: the random draw uses a generator of the calling thread.
+    *
+    * @param module The module that writes the message.
+    * @param level The level of the message.
+    * @return True if the message has to be logged, otherwise false.
+    */
+   bool shouldLog(const QString &module, LogLevel level) const;
+
+   /**
+    * @brief shouldLog Version of shouldLog for a level known at compile time, used by the QLog_* macros.
+    *
+    * @param module The module that writes the message.
+    * @return True if the message has to be logged, otherwise false.
+    */
+   template<LogLevel Level>
+   bool shouldLog(const QString &module) const
+   {
+      return static_cast<int>(Level) >= QLOGGER_MIN_LEVEL && shouldLog(module, Level);
+   }
+
+   /**
+    * @brief shouldLog Versions of shouldLog for a module handle, used by the QLog_* macros.
+    */
+   bool shouldLog(QLoggerModule module, LogLevel level) const { return shouldLog(module.mEntry, level); }
+
+   template<LogLevel Level>
+   bool shouldLog(QLoggerModule module) const
+   {
+      return static_cast<int>(Level) >= QLOGGER_MIN_LEVEL && shouldLog(module, Level);
+   }
+
+   /**
+    * @brief setModuleLevel Overrides the level of a module and of its submodules, named with dots: the level of "net"
+    * applies to "net.http" and "net.http.client" as well, unless a submodule has an override of its own. The
+    * overrides take precedence over the level of the destinations, so a noisy subsystem can log Debug messages into
+    * a shared file kept at Warning.
+    *
+    * The overrides are resolved once for every module with a destination, logging still only reads one level.
+    *
+    * @param module The module, or the parent of the modules, to override.
+    * @param level The level of the module and of its submodules.
+    */
+   void setModuleLevel(const QString &module, LogLevel level);
+
+   /**
+    * @brief clearModuleLevel Removes the override of a module, that gets the level of its closest parent with an
+    * override again, or the one of its destination.
+    * @param module The module given to setModuleLevel.
+    */
+   void clearModuleLevel(const QString &module);
+
+   /**
+    * @brief setModuleSampling Logs only a part of the messages of a module, chosen at random.
+    * @param module The module to sample.
+    * @param rate The probability to log a message, from 0 to 1. 1 logs all the messages.
+    * @param maxLevel The messages with a higher level are always logged.
+    */
+   void setModuleSampling(const QString &module, double rate, LogLevel maxLevel = LogLevel::Info);
+
+   /**
+    * @brief setCallSiteRateLimit Limits how many messages every call of the QLog_* macros can log. The messages
+    * beyond the limit are dropped on the calling thread, before the message is built, and their amount is logged
+    * as "Suppressed N similar messages" with the next message of the same call site that is allowed, or within a
+    * second if the call site does not log again.
+    *
+    * @param messagesPerSecond The sustained rate of every call site. Zero disables the limit.
+    * @param burst The amount of messages a call site can log at once.
+    */
+   void setCallSiteRateLimit(int messagesPerSecond, int burst = 1);
+
+   /**
+    * @brief acquireCallSite Applies the rate limit of the call sites. Used by the QLog_* macros.
+    * @param limiter The limiter of the call site.
+    * @param module The module that writes the message.
+    * @param level The level of the message.
+    * @param function The function of the call site.
+    * @param file The file of the call site.
+    * @param line The line of the call site.
+    * @return True if the message can be logged, otherwise false.
+    */
+   bool acquireCallSite(QLoggerRateLimiter &limiter, const QString &module, LogLevel level, const char *function,
+                        const char *file, int line)
+   {
+      return mCallSiteInterval.load(std::memory_order_relaxed) <= 0
+          || acquireLimitedCallSite(limiter, module, level, function, file, line);
+   }
+   bool acquireCallSite(QLoggerRateLimiter &limiter, QLoggerModule module, LogLevel level, const char *function,
+                        const char *file, int line)
+   {
+      return mCallSiteInterval.load(std::memory_order_relaxed) <= 0
+          || acquireLimitedCallSite(limiter, module.name(), level, function, file, line);
+   }
+
+   /**
+    * @brief addSink Adds an output to the destination of a module, for instance a syslog or a network collector. The
+    * sink gets the batches of the destination after its file and its console, and every module logging into the same
+    * file shares it.
+    *
+    * @param module The module with a destination.
+    * @param sink The sink. It is owned by the destination from now on, unless the module has no destination.
+    * @return True if the sink has been added, false if the module has no destination.
+    */
+   bool addSink(const QString &module, QLoggerSink *sink);
+
+   /**
+    * @brief getStatistics Gets a snapshot of the counters of every writer, to export them to a metrics system. The
+    * counters are relaxed atomics, so it does not slow down the logging threads.
+    * @return The statistics of the writers, with the modules they write.
+    */
+   QVector<WriterStatistics> getStatistics() const;
+
+   /**
+    * @brief flush Writes the messages logged so far by all the writers and flushes their files, synchronizing them
+    * to the disk unless their fsync policy is LogFsyncPolicy::Never.
+    *
+    * @param timeout The maximum time to wait in milliseconds, shared by all the writers. -1 waits forever.
+    * @return True if every writer has flushed its messages in time, otherwise false.
+    */
+   bool flush(int timeout = -1);
+
+   /**
+    * @brief installCrashHandler Installs a handler for the fatal signals (SIGSEGV, SIGABRT, SIGBUS, SIGFPE and
+    * SIGILL) that writes the data the persistent files still keep in memory, and the memory of the destinations in
+    * LogMode::Memory, before the process dies. Only the messages already formatted by the writers can be saved: the
+    * ones still queued are lost. The handlers installed before are kept and get the signal afterwards, so another
+    * crash reporter still works. Installing it more than once has no effect.
+    */
+   static void installCrashHandler();
+
+   /**
+    * @brief dumpMemory Appends the messages kept by the destinations in LogMode::Memory to their files.
+    *
+    * @param timeout The maximum time to wait in milliseconds, shared by all the writers. -1 waits forever.
+    * @return True if every destination in LogMode::Memory has been dumped in time, otherwise false.
+    */
+   bool dumpMemory(int timeout = -1);
 
    /**
     * @brief Whether the QLogger is paused or not.
@@ -147,6 +474,66 @@ public:
    void setDefaultMode(LogMode mode) { mDefaultMode = mode; }
    void setDefaultMaxFileSize(int maxFileSize) { mDefaultMaxFileSize = maxFileSize; }
    void setDefaultMessageOptions(LogMessageDisplays messageOptions) { mDefaultMessageOptions = messageOptions; }
+   void setDefaultConsoleOptions(LogConsoleOptions consoleOptions) { mDefaultConsoleOptions = consoleOptions; }
+   void setDefaultTimestampFormat(LogTimestampFormat timestampFormat) { mDefaultTimestampFormat = timestampFormat; }
+   void setDefaultFileAccess(LogFileAccess fileAccess) { mDefaultFileAccess = fileAccess; }
+   void setDefaultFileFormat(LogFileFormat fileFormat) { mDefaultFileFormat = fileFormat; }
+   void setDefaultCompression(LogCompression compression) { mDefaultCompression = compression; }
+   void setDefaultRetention(int maxFiles, qint64 maxTotalSize = 0, int maxAgeDays = 0)
+   {
+      mDefaultRetentionMaxFiles = maxFiles;
+      mDefaultRetentionMaxTotalSize = maxTotalSize;
+      mDefaultRetentionMaxAgeDays = maxAgeDays;
+   }
+   void setDefaultWakePolicy(int batchSize, int maxLatency)
+   {
+      mDefaultWakeBatchSize = batchSize;
+      mDefaultMaxWakeLatency = maxLatency;
+   }
+   void setDefaultQueueCapacity(int capacity, LogQueuePolicy policy = LogQueuePolicy::DropNewest,
+                                LogLevel dropLevel = LogLevel::Warning)
+   {
+      mDefaultQueueCapacity = capacity;
+      mDefaultQueuePolicy = policy;
+      mDefaultDropLevel = dropLevel;
+   }
+   void setDefaultFlushPolicy(int flushSize, int flushInterval)
+   {
+      mDefaultFlushSize = flushSize;
+      mDefaultFlushInterval = flushInterval;
+   }
+   void setDefaultMemoryCapacity(int capacity) { mDefaultMemoryCapacity = capacity; }
+   void setDefaultIndexInterval(qint64 interval) { mDefaultIndexInterval = interval; }
+   void setDefaultFsyncPolicy(LogFsyncPolicy policy, int interval = 1000)
+   {
+      mDefaultFsyncPolicy = policy;
+      mDefaultFsyncInterval = interval;
+   }
+
+   /**
+    * @brief setThreadName Sets the name that identifies the calling thread in the log messages instead of its
+    * address, for instance "io-worker-3".
+    *
+    * @param name The name of the thread. An empty name restores the default identifier.
+    */
+   static void setThreadName(const QString &name);
+
+   /**
+    * @brief setNonWriterQueueLimit Sets the amount of messages kept per module while the module has no destination
+    * yet. The messages beyond the limit are dropped.
+    *
+    * @param limit The maximum amount of messages per module.
+    */
+   void setNonWriterQueueLimit(int limit);
+
+   /**
+    * @brief setWriterThreadPoolSize Makes the destinations added afterwards share a fixed amount of worker threads
+    * instead of having one thread each. The pool is created with the first of those destinations, later changes of
+    * the size only apply if the pool does not exist yet.
+    *
+    * @param size The amount of worker threads. Zero means one thread per destination.
+    */
+   void setWriterThreadPoolSize(int size);
 
    /**
     * @brief overwriteLogMode Overwrites the logging mode in all the destinations. Sets the default logging mode.
@@ -175,10 +562,38 @@ public:
    void moveLogsWhenClose(const QString &newLogsFolder) { mNewLogsFolder = newLogsFolder; }
 
 private:
+   using ModuleEntry = QLoggerModuleEntry;
+
+   class SuppressionReporter;
+
+   /**
+    * @brief A call site whose limiter has refused messages that are not reported yet.
+    */
+   struct SuppressedCallSite
+   {
+      QLoggerRateLimiter *limiter = nullptr;
+      QString module;
+      LogLevel level = LogLevel::Info;
+      const char *function = nullptr;
+      const char *file = nullptr;
+      int line = 0;
+   };
+
+   /**
+    * @brief The sampling of a module, kept even if the module has no destination yet.
+    */
+   struct ModuleSampling
+   {
+      double rate = 1.0;
+      LogLevel maxLevel = LogLevel::Info;
+   };
+
+   using ModuleSnapshot = QHash<QString, ModuleEntry *>;
+
    /**
     * @brief Checks if the logger is stop
     */
-   bool mIsStop = false;
+   std::atomic<bool> mIsStop { false };
 
    /**
     * @brief Map that stores the module and the file it is assigned.
@@ -186,9 +601,55 @@ private:
    QMap<QString, QLoggerWriter *> mModuleDest;
 
    /**
-    * @brief Defines the queue of messages when no writers have been set yet.
+    * @brief The writers of mModuleDest, once each. Several modules share the writer of a file.
     */
-   QMultiMap<QString, QVector<QVariant>> mNonWriterQueue;
+   QVector<QLoggerWriter *> mWriters;
+
+   /**
+    * @brief Entries for the modules in mModuleDest. They live as long as the manager.
+    */
+   ModuleSnapshot mModuleEntries;
+
+   /**
+    * @brief Read-only copy of mModuleEntries used by the logging threads. It is replaced, never modified, every
+    * time a destination is added.
+    */
+   std::atomic<const ModuleSnapshot *> mModuleSnapshot { new ModuleSnapshot() };
+
+   /**
+    * @brief Snapshots that have been replaced. A logging thread could still be reading them, so they are only
+    * released when the manager is destroyed.
+    */
+   QVector<const ModuleSnapshot *> mRetiredSnapshots;
+
+   /**
+    * @brief Defines the queue of messages when no writers have been set yet. It is only touched by the messages of
+    * modules without destination, and drained once when the destination is added.
+    */
+   QHash<QString, QVector<LogRecord>> mNonWriterQueue;
+   int mNonWriterQueueLimit = 100;
+
+   QHash<QString, ModuleSampling> mModuleSampling;
+   /**
+    * @brief Level overrides of setModuleLevel, by module or parent module.
+    */
+   QHash<QString, LogLevel> mModuleLevels;
+
+   /**
+    * @brief Rate limit of the call sites: the time in nanoseconds between two messages, zero without limit.
+    */
+   std::atomic<qint64> mCallSiteInterval { 0 };
+   std::atomic<int> mCallSiteBurst { 1 };
+
+   /**
+    * @brief Call sites with suppressed messages, reported periodically by mSuppressionReporter. A call site is only
+    * added by the first message refused since its last report, so the mutex is not taken on every refusal.
+    */
+   QMutex mSuppressedMutex;
+   QWaitCondition mSuppressionWake;
+   QVector<SuppressedCallSite> mSuppressedCallSites;
+   SuppressionReporter *mSuppressionReporter = nullptr;
+   bool mSuppressionQuit = false;
 
    /**
     * @brief Default values for QLoggerWritter parameters. Useful for multiple QLoggerWritter.
@@ -201,15 +662,36 @@ private:
    LogLevel mDefaultLevel = LogLevel::Warning;
    int mDefaultMaxFileSize = 1024 * 1024; //! @note 1Mio
    LogMessageDisplays mDefaultMessageOptions = LogMessageDisplay::Default;
+   LogConsoleOptions mDefaultConsoleOptions;
+   LogTimestampFormat mDefaultTimestampFormat = LogTimestampFormat::EpochSeconds;
+   LogFileAccess mDefaultFileAccess = LogFileAccess::OpenPerBatch;
+   LogFileFormat mDefaultFileFormat = LogFileFormat::Text;
+   LogCompression mDefaultCompression = LogCompression::None;
+   int mDefaultRetentionMaxFiles = 0; //! @note No limit
+   qint64 mDefaultRetentionMaxTotalSize = 0; //! @note No limit
+   int mDefaultRetentionMaxAgeDays = 0; //! @note No limit
+   int mDefaultFlushSize = 64 * 1024; //! @note 64Kio
+   int mDefaultFlushInterval = 1000; //! @note 1s
+   int mDefaultWakeBatchSize = 1;
+   int mDefaultMaxWakeLatency = 0; //! @note In microseconds
+   int mDefaultQueueCapacity = 0; //! @note No limit
+   LogQueuePolicy mDefaultQueuePolicy = LogQueuePolicy::DropNewest;
+   LogLevel mDefaultDropLevel = LogLevel::Warning;
+   LogFsyncPolicy mDefaultFsyncPolicy = LogFsyncPolicy::Never;
+   int mDefaultFsyncInterval = 1000; //! @note 1s
+   int mDefaultMemoryCapacity = 4 * 1024 * 1024; //! @note 4Mio
+   qint64 mDefaultIndexInterval = 0; //! @note Not indexed
    QString mNewLogsFolder;
+   int mWriterThreadPoolSize = 0;
+   QLoggerWorkerPool *mWorkerPool = nullptr;
 
 /**
  * @brief Mutex to make the method thread-safe.
  */
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-   QMutex mMutex { QMutex::Recursive };
+   mutable QMutex mMutex { QMutex::Recursive };
 #else
-   QRecursiveMutex mMutex;
+   mutable QRecursiveMutex mMutex;
 #endif
 
    /**
@@ -233,13 +715,78 @@ private:
     * @return the newly created QLoggerWriter instance.
     */
    QLoggerWriter *createWriter(const QString &fileDest, LogLevel level, const QString &fileFolderDestination,
-                               LogMode mode, LogFileDisplay fileSuffixIfFull, LogMessageDisplays messageOptions) const;
+                               LogMode mode, LogFileDisplay fileSuffixIfFull, LogMessageDisplays messageOptions);
+
+   /**
+    * @brief Gets the writer that already logs into the file that the given parameters resolve to.
+    * @param fileDest The file name and path to print logs.
+    * @param fileFolderDestination The complete folder destination.
+    * @return The writer or nullptr if no module logs into that file yet.
+    */
+   QLoggerWriter *findWriter(const QString &fileDest, const QString &fileFolderDestination) const;
 
    void startWriter(const QString &module, QLoggerWriter *log, LogMode mode, bool notify);
 
    /**
-    * @brief Checks the queue and writes the messages if the writer is the correct one. The queue is emptied
-    * for that module.
+    * @brief Publishes a new snapshot of mModuleDest for the logging threads. Must be called with mMutex held.
+    */
+   void publishWriters();
+
+   /**
+    * @brief Recomputes the enabled level and the sampling of every module after a change of level, mode, pause
+    * state or sampling. Must be called with mMutex held.
+    */
+   void updateEnabledLevels();
+
+   /**
+    * @brief Gets the level of a module: the override of the module or of its closest parent, otherwise the level of
+    * its writer. Must be called with mMutex held.
+    */
+   LogLevel resolveModuleLevel(const QString &module, const QLoggerWriter *writer) const;
+
+   /**
+    * @brief Slow path of acquireCallSite when the rate limit is set.
+    */
+   bool acquireLimitedCallSite(QLoggerRateLimiter &limiter, const QString &module, LogLevel level,
+                               const char *function, const char *file, int line);
+
+   /**
+    * @brief Logs the amount of suppressed messages of the call sites in mSuppressedCallSites and clears the list.
+    */
+   void reportSuppressedMessages();
+
+   /**
+    * @brief Loop of mSuppressionReporter: reports the suppressed messages every second until the manager quits.
+    */
+   void runSuppressionReports();
+
+   /**
+    * @brief Filters the record by the module level and hands it to its writer.
+    * @param record The record to log.
+    */
+   void enqueueRecord(LogRecord &&record);
+
+   /**
+    * @brief Version of enqueueRecord for a module already looked up.
+    * @param entry The entry of the module, null if the module is unknown.
+    * @param record The record to log.
+    */
+   void enqueueRecord(const ModuleEntry *entry, LogRecord &&record);
+
+   /**
+    * @brief Version of shouldLog for a module already looked up.
+    */
+   bool shouldLog(const ModuleEntry *entry, LogLevel level) const;
+
+   /**
+    * @brief Slow path of enqueueRecord for modules that had no destination in the snapshot. The message is kept
+    * until the destination is added.
+    */
+   void enqueueNonWriterMessage(LogRecord &&record);
+
+   /**
+    * @brief Writes the messages logged before the destination of the module was added, unless the writer is
+    * paused. The queue is emptied for that module.
     * @param module The module to dequeue the messages from
     */
    void writeAndDequeueMessages(const QString &module);
@@ -262,15 +809,102 @@ extern void QLog_(const QString &module, QLogger::LogLevel level, const QString
 
 }
 
+/**
+ * @brief Expansion of the QLog_* macros stripped by QLOGGER_MIN_LEVEL. The arguments are still type-checked, but never
+ * evaluated.
+ */
+#define QLOGGER_DISCARD(module, message)                                                                               \
+   do                                                                                                                  \
+   {                                                                                                                   \
+      (void)sizeof(module);                                                                                            \
+      (void)sizeof(message);                                                                                           \
+   } while (0)
+
+/**
+ * @brief Used by the QLog_*Fields macros to store a message with typed key/value fields, given as a list of
+ * {key, value} pairs, for instance QLog_InfoFields("Network", "Request done", {"status", 200}, {"ms", 12.5}). The
+ * message and the fields are only evaluated if the level is enabled for the module.
+ */
+#define QLOGGER_LOG_FIELDS(level, module, message, ...)                                                                \
+   do                                                                                                                  \
+   {                                                                                                                   \
+      static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                              \
+      static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                          \
+      const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                             \
+      const auto qloggerModule_ = QLogger::moduleArgument(module);                                                     \
+      if (qloggerManager_->shouldLog<level>(qloggerModule_)                                                            \
+          && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, level, __FUNCTION__, qloggerFile_,      \
+                                              __LINE__))                                                               \
+         qloggerManager_->enqueueMessage(qloggerModule_, level, message, QVector<QLogger::LogField> { __VA_ARGS__ },   \
+                                         __FUNCTION__, qloggerFile_, __LINE__);                                        \
+   } while (0)
+
+#if QLOGGER_MIN_LEVEL <= 0
+#   define QLog_TraceFields(module, message, ...)                                                                      \
+      QLOGGER_LOG_FIELDS(QLogger::LogLevel::Trace, module, message, __VA_ARGS__)
+#else
+#   define QLog_TraceFields(module, message, ...) QLOGGER_DISCARD(module, message)
+#endif
+
+#if QLOGGER_MIN_LEVEL <= 1
+#   define QLog_DebugFields(module, message, ...)                                                                      \
+      QLOGGER_LOG_FIELDS(QLogger::LogLevel::Debug, module, message, __VA_ARGS__)
+#else
+#   define QLog_DebugFields(module, message, ...) QLOGGER_DISCARD(module, message)
+#endif
+
+#if QLOGGER_MIN_LEVEL <= 2
+#   define QLog_InfoFields(module, message, ...)                                                                       \
+      QLOGGER_LOG_FIELDS(QLogger::LogLevel::Info, module, message, __VA_ARGS__)
+#else
+#   define QLog_InfoFields(module, message, ...) QLOGGER_DISCARD(module, message)
+#endif
+
+#if QLOGGER_MIN_LEVEL <= 3
+#   define QLog_WarningFields(module, message, ...)                                                                    \
+      QLOGGER_LOG_FIELDS(QLogger::LogLevel::Warning, module, message, __VA_ARGS__)
+#else
+#   define QLog_WarningFields(module, message, ...) QLOGGER_DISCARD(module, message)
+#endif
+
+#if QLOGGER_MIN_LEVEL <= 4
+#   define QLog_ErrorFields(module, message, ...)                                                                      \
+      QLOGGER_LOG_FIELDS(QLogger::LogLevel::Error, module, message, __VA_ARGS__)
+#else
+#   define QLog_ErrorFields(module, message, ...) QLOGGER_DISCARD(module, message)
+#endif
+
+#if QLOGGER_MIN_LEVEL <= 5
+#   define QLog_FatalFields(module, message, ...)                                                                      \
+      QLOGGER_LOG_FIELDS(QLogger::LogLevel::Fatal, module, message, __VA_ARGS__)
+#else
+#   define QLog_FatalFields(module, message, ...) QLOGGER_DISCARD(module, message)
+#endif
+
 #ifndef QLog_Trace
 /**
- * @brief Used to store Trace level messages.
+ * @brief Used to store Trace level messages. The message is only evaluated if the level is enabled for the
+ * module.
  * @param module The module that the message references.
  * @param message The message.
  */
-#   define QLog_Trace(module, message)                                                                                 \
-      QLogger::QLoggerManager::getInstance()->enqueueMessage(module, QLogger::LogLevel::Trace, message, __FUNCTION__,  \
-                                                             __FILE__, __LINE__)
+#   if QLOGGER_MIN_LEVEL <= 0
+#      define QLog_Trace(module, message)                                                                              \
+         do                                                                                                            \
+         {                                                                                                             \
+            static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                        \
+            static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                    \
+            const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                       \
+            const auto qloggerModule_ = QLogger::moduleArgument(module);                                               \
+            if (qloggerManager_->shouldLog<QLogger::LogLevel::Trace>(qloggerModule_)                                   \
+                && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, QLogger::LogLevel::Trace,         \
+                                                    __FUNCTION__, qloggerFile_, __LINE__))                             \
+               qloggerManager_->enqueueMessage(qloggerModule_, QLogger::LogLevel::Trace, message, __FUNCTION__,        \
+                                               qloggerFile_, __LINE__);                                                \
+         } while (0)
+#   else
+#      define QLog_Trace(module, message) QLOGGER_DISCARD(module, message)
+#   endif
 #endif
 
 #ifndef QLog_Debug
@@ -279,9 +913,23 @@ extern void QLog_(const QString &module, QLogger::LogLevel level, const QString
  * @param module The module that the message references.
  * @param message The message.
  */
-#   define QLog_Debug(module, message)                                                                                 \
-      QLogger::QLoggerManager::getInstance()->enqueueMessage(module, QLogger::LogLevel::Debug, message, __FUNCTION__,  \
-                                                             __FILE__, __LINE__)
+#   if QLOGGER_MIN_LEVEL <= 1
+#      define QLog_Debug(module, message)                                                                              \
+         do                                                                                                            \
+         {                                                                                                             \
+            static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                        \
+            static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                    \
+            const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                       \
+            const auto qloggerModule_ = QLogger::moduleArgument(module);                                               \
+            if (qloggerManager_->shouldLog<QLogger::LogLevel::Debug>(qloggerModule_)                                   \
+                && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, QLogger::LogLevel::Debug,         \
+                                                    __FUNCTION__, qloggerFile_, __LINE__))                             \
+               qloggerManager_->enqueueMessage(qloggerModule_, QLogger::LogLevel::Debug, message, __FUNCTION__,        \
+                                               qloggerFile_, __LINE__);                                                \
+         } while (0)
+#   else
+#      define QLog_Debug(module, message) QLOGGER_DISCARD(module, message)
+#   endif
 #endif
 
 #ifndef QLog_Info
@@ -290,9 +938,23 @@ extern void QLog_(const QString &module, QLogger::LogLevel level, const QString
  * @param module The module that the message references.
  * @param message The message.
  */
-#   define QLog_Info(module, message)                                                                                  \
-      QLogger::QLoggerManager::getInstance()->enqueueMessage(module, QLogger::LogLevel::Info, message, __FUNCTION__,   \
-                                                             __FILE__, __LINE__)
+#   if QLOGGER_MIN_LEVEL <= 2
+#      define QLog_Info(module, message)                                                                               \
+         do                                                                                                            \
+         {                                                                                                             \
+            static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                        \
+            static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                    \
+            const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                       \
+            const auto qloggerModule_ = QLogger::moduleArgument(module);                                               \
+            if (qloggerManager_->shouldLog<QLogger::LogLevel::Info>(qloggerModule_)                                    \
+                && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, QLogger::LogLevel::Info,          \
+                                                    __FUNCTION__, qloggerFile_, __LINE__))                             \
+               qloggerManager_->enqueueMessage(qloggerModule_, QLogger::LogLevel::Info, message, __FUNCTION__,         \
+                                               qloggerFile_, __LINE__);                                                \
+         } while (0)
+#   else
+#      define QLog_Info(module, message) QLOGGER_DISCARD(module, message)
+#   endif
 #endif
 
 #ifndef QLog_Warning
@@ -301,9 +963,23 @@ extern void QLog_(const QString &module, QLogger::LogLevel level, const QString
  * @param module The module that the message references.
  * @param message The message.
  */
-#   define QLog_Warning(module, message)                                                                               \
-      QLogger::QLoggerManager::getInstance()->enqueueMessage(module, QLogger::LogLevel::Warning, message,              \
-                                                             __FUNCTION__, __FILE__, __LINE__)
+#   if QLOGGER_MIN_LEVEL <= 3
+#      define QLog_Warning(module, message)                                                                            \
+         do                                                                                                            \
+         {                                                                                                             \
+            static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                        \
+            static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                    \
+            const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                       \
+            const auto qloggerModule_ = QLogger::moduleArgument(module);                                               \
+            if (qloggerManager_->shouldLog<QLogger::LogLevel::Warning>(qloggerModule_)                                 \
+                && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, QLogger::LogLevel::Warning,       \
+                                                    __FUNCTION__, qloggerFile_, __LINE__))                             \
+               qloggerManager_->enqueueMessage(qloggerModule_, QLogger::LogLevel::Warning, message, __FUNCTION__,      \
+                                               qloggerFile_, __LINE__);                                                \
+         } while (0)
+#   else
+#      define QLog_Warning(module, message) QLOGGER_DISCARD(module, message)
+#   endif
 #endif
 
 #ifndef QLog_Error
@@ -312,9 +988,23 @@ extern void QLog_(const QString &module, QLogger::LogLevel level, const QString
  * @param module The module that the message references.
  * @param message The message.
  */
-#   define QLog_Error(module, message)                                                                                 \
-      QLogger::QLoggerManager::getInstance()->enqueueMessage(module, QLogger::LogLevel::Error, message, __FUNCTION__,  \
-                                                             __FILE__, __LINE__)
+#   if QLOGGER_MIN_LEVEL <= 4
+#      define QLog_Error(module, message)                                                                              \
+         do                                                                                                            \
+         {                                                                                                             \
+            static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                        \
+            static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                    \
+            const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                       \
+            const auto qloggerModule_ = QLogger::moduleArgument(module);                                               \
+            if (qloggerManager_->shouldLog<QLogger::LogLevel::Error>(qloggerModule_)                                   \
+                && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, QLogger::LogLevel::Error,         \
+                                                    __FUNCTION__, qloggerFile_, __LINE__))                             \
+               qloggerManager_->enqueueMessage(qloggerModule_, QLogger::LogLevel::Error, message, __FUNCTION__,        \
+                                               qloggerFile_, __LINE__);                                                \
+         } while (0)
+#   else
+#      define QLog_Error(module, message) QLOGGER_DISCARD(module, message)
+#   endif
 #endif
 
 #ifndef QLog_Fatal
@@ -323,7 +1013,21 @@ extern void QLog_(const QString &module, QLogger::LogLevel level, const QString
  * @param module The module that the message references.
  * @param message The message.
  */
-#   define QLog_Fatal(module, message)                                                                                 \
-      QLogger::QLoggerManager::getInstance()->enqueueMessage(module, QLogger::LogLevel::Fatal, message, __FUNCTION__,  \
-                                                             __FILE__, __LINE__)
+#   if QLOGGER_MIN_LEVEL <= 5
+#      define QLog_Fatal(module, message)                                                                              \
+         do                                                                                                            \
+         {                                                                                                             \
+            static QLogger::QLoggerRateLimiter qloggerLimiter_;                                                        \
+            static constexpr auto qloggerFile_ = QLogger::sourceFileName(__FILE__);                                    \
+            const auto qloggerManager_ = QLogger::QLoggerManager::getInstance();                                       \
+            const auto qloggerModule_ = QLogger::moduleArgument(module);                                               \
+            if (qloggerManager_->shouldLog<QLogger::LogLevel::Fatal>(qloggerModule_)                                   \
+                && qloggerManager_->acquireCallSite(qloggerLimiter_, qloggerModule_, QLogger::LogLevel::Fatal,         \
+                                                    __FUNCTION__, qloggerFile_, __LINE__))                             \
+               qloggerManager_->enqueueMessage(qloggerModule_, QLogger::LogLevel::Fatal, message, __FUNCTION__,        \
+                                               qloggerFile_, __LINE__);                                                \
+         } while (0)
+#   else
+#      define QLog_Fatal(module, message) QLOGGER_DISCARD(module, message)
+#   endif
 #endif
@@ -1,8 +1,33 @@
 INCLUDEPATH += $$PWD
 
 SOURCES += $$PWD/QLogger.cpp \
+    $$PWD/QLoggerBinary.cpp \
+    $$PWD/QLoggerConsole.cpp \
+    $$PWD/QLoggerDataEnd.cpp \
+    $$PWD/QLoggerFormatter.cpp \
+    $$PWD/QLoggerIndex.cpp \
+    $$PWD/QLoggerReader.cpp \
+    $$PWD/QLoggerRingBuffer.cpp \
+    $$PWD/QLoggerRotation.cpp \
+    $$PWD/QLoggerWorkerPool.cpp \
     $$PWD/QLoggerWriter.cpp
 
 HEADERS += $$PWD/QLogger.h \
+    $$PWD/QLoggerBinary.h \
+    $$PWD/QLoggerConsole.h \
+    $$PWD/QLoggerDataEnd.h \
+    $$PWD/QLoggerFormatter.h \
+    $$PWD/QLoggerIndex.h \
     $$PWD/QLoggerLevel.h \
+    $$PWD/QLoggerQueue.h \
+    $$PWD/QLoggerRateLimiter.h \
+    $$PWD/QLoggerReader.h \
+    $$PWD/QLoggerRecord.h \
+    $$PWD/QLoggerRingBuffer.h \
+    $$PWD/QLoggerRotation.h \
+    $$PWD/QLoggerSink.h \
+    $$PWD/QLoggerStatistics.h \
+    $$PWD/QLoggerWorkerPool.h \
     $$PWD/QLoggerWriter.h
+
+!isEmpty(QLOGGER_MIN_LEVEL): DEFINES += QLOGGER_MIN_LEVEL=$$QLOGGER_MIN_LEVEL
@@ -0,0 +1,22 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+# The numbers are only meaningful with optimizations
+CONFIG -= debug
+CONFIG += release
+
+SOURCES += \
+        main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+
+!build_pass:message("QLoggerBenchmark: importing QLogger")
+if( !include($$PWD/../QLogger.pri) ) {
+    error( Could not find the QLogger.pri file. )
+}
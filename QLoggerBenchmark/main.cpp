@@ -0,0 +1,293 @@
+#include <QLogger.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace QLogger;
+
+namespace
+{
+/**
+ * @brief The Result struct holds the measures of one benchmark.
+ */
+struct Result
+{
+   QString name;
+   int threads = 1;
+   qint64 messages = 0;
+   qint64 elapsedNs = 0;
+   std::vector<qint64> latencies;
+   /**
+    * @brief Time for the writer to write the backlog once the producers are done, -1 if nothing is written.
+    */
+   qint64 drainMs = -1;
+   int files = 0;
+};
+
+qint64 now()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+       .count();
+}
+
+qint64 percentile(const std::vector<qint64> &sorted, double value)
+{
+   if (sorted.empty())
+      return 0;
+
+   const auto index = static_cast<size_t>(value * static_cast<double>(sorted.size() - 1));
+
+   return sorted[index];
+}
+
+/**
+ * @brief Prints a result as one JSON object per line, so the output can be tracked by the CI.
+ */
+void printResult(Result &result)
+{
+   std::sort(result.latencies.begin(), result.latencies.end());
+
+   const auto seconds = static_cast<double>(result.elapsedNs) / 1e9;
+
+   std::printf("{\"benchmark\":\"%s\",\"threads\":%d,\"messages\":%lld,\"seconds\":%.6f,"
+               "\"messages_per_second\":%.0f,\"p50_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"drain_ms\":%lld,"
+               "\"files\":%d}\n",
+               qPrintable(result.name), result.threads, static_cast<long long>(result.messages), seconds,
+               seconds > 0 ? static_cast<double>(result.messages) / seconds : 0.0,
+               static_cast<long long>(percentile(result.latencies, 0.5)),
+               static_cast<long long>(percentile(result.latencies, 0.99)),
+               static_cast<long long>(percentile(result.latencies, 0.999)), static_cast<long long>(result.drainMs),
+               result.files);
+   std::fflush(stdout);
+}
+
+/**
+ * @brief Logs from several threads at once and measures the time of every call.
+ * @param module The module to log into.
+ * @param threads The amount of producer threads.
+ * @param messagesPerThread The amount of messages logged by each thread.
+ * @param filtered If true the messages are logged with a level below the one of the destination.
+ * @param useHandle If true the messages are logged with the handle of the module instead of its name.
+ */
+Result produce(const QString &module, int threads, qint64 messagesPerThread, bool filtered, bool useHandle)
+{
+   const auto handle = QLoggerManager::getInstance()->module(module);
+
+   Result result;
+   result.threads = threads;
+   result.messages = threads * messagesPerThread;
+
+   std::vector<std::vector<qint64>> latencies(static_cast<size_t>(threads));
+   std::vector<std::thread> producers;
+   std::atomic<int> ready { 0 };
+   std::atomic<bool> go { false };
+
+   for (auto t = 0; t < threads; ++t)
+   {
+      producers.emplace_back([&, t]() {
+         auto &samples = latencies[static_cast<size_t>(t)];
+         samples.reserve(static_cast<size_t>(messagesPerThread));
+
+         QLoggerManager::setThreadName(QString("producer-%1").arg(t));
+
+         const auto message = QStringLiteral("Benchmark message with a payload of a usual length for a log line");
+
+         ++ready;
+
+         while (!go)
+            std::this_thread::yield();
+
+         for (qint64 i = 0; i < messagesPerThread; ++i)
+         {
+            const auto start = now();
+
+            if (filtered)
+               QLog_Debug(module, message);
+            else if (useHandle)
+               QLog_Info(handle, message);
+            else
+               QLog_Info(module, message);
+
+            samples.push_back(now() - start);
+         }
+      });
+   }
+
+   while (ready < threads)
+      std::this_thread::yield();
+
+   const auto start = now();
+   go = true;
+
+   for (auto &producer : producers)
+      producer.join();
+
+   result.elapsedNs = now() - start;
+
+   for (const auto &samples : latencies)
+      result.latencies.insert(result.latencies.end(), samples.begin(), samples.end());
+
+   return result;
+}
+
+/**
+ * @brief Waits until the writers have written every message logged so far.
+ * @param folder The folder of the destination.
+ * @param files Set to the amount of files in the folder.
+ * @return The time in milliseconds the writers needed to write their queues.
+ */
+qint64 waitForDrain(const QString &folder, int &files)
+{
+   const auto start = now();
+
+   QLoggerManager::getInstance()->flush();
+
+   const auto elapsed = now() - start;
+
+   files = QDir(folder).entryInfoList(QDir::Files).count();
+
+   return elapsed / (1000 * 1000);
+}
+
+/**
+ * @brief Runs a benchmark in its own module and folder, so the destinations do not interfere.
+ */
+Result measure(const QString &name, const QString &root, LogMode mode, LogLevel level, int threads,
+               qint64 messagesPerThread, bool filtered = false, bool useHandle = false)
+{
+   const auto folder = QDir(root).filePath(name);
+   const auto manager = QLoggerManager::getInstance();
+
+   manager->addDestination(QString("%1.log").arg(name), name, level, folder, mode, LogFileDisplay::Number,
+                           LogMessageDisplay::Default, false);
+
+   auto result = produce(name, threads, messagesPerThread, filtered, useHandle);
+   result.name = name;
+
+   if (mode == LogMode::OnlyFile && !filtered)
+      result.drainMs = waitForDrain(folder, result.files);
+
+   return result;
+}
+
+void run(const QString &name, const QString &root, LogMode mode, LogLevel level, int threads,
+         qint64 messagesPerThread, bool filtered = false, bool useHandle = false)
+{
+   auto result = measure(name, root, mode, level, threads, messagesPerThread, filtered, useHandle);
+
+   printResult(result);
+}
+
+/**
+ * @brief Drops the console output, so the speed of the terminal is not measured.
+ */
+void discardMessage(QtMsgType, const QMessageLogContext &, const QString &) { }
+}
+
+int main(int argc, char *argv[])
+{
+   QCoreApplication app(argc, argv);
+   QCoreApplication::setApplicationName(QStringLiteral("QLoggerBenchmark"));
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription(
+       QStringLiteral("Measures the throughput and the caller latency of QLogger. Prints one JSON object per line."));
+   parser.addHelpOption();
+
+   const QCommandLineOption messagesOption(QStringLiteral("messages"),
+                                           QStringLiteral("Messages logged by each benchmark, split between its producer threads."),
+                                           QStringLiteral("count"), QStringLiteral("200000"));
+   const QCommandLineOption threadsOption(QStringLiteral("max-threads"),
+                                          QStringLiteral("Maximum amount of producer threads."),
+                                          QStringLiteral("count"), QString::number(QThread::idealThreadCount()));
+   const QCommandLineOption folderOption(QStringLiteral("folder"),
+                                         QStringLiteral("Folder for the log files, removed at the end."),
+                                         QStringLiteral("path"),
+                                         QDir::temp().filePath(QStringLiteral("QLoggerBenchmark")));
+
+   parser.addOption(messagesOption);
+   parser.addOption(threadsOption);
+   parser.addOption(folderOption);
+   parser.process(app);
+
+   const auto messages = qMax<qint64>(1, parser.value(messagesOption).toLongLong());
+   const auto maxThreads = qMax(1, parser.value(threadsOption).toInt());
+   const auto root = parser.value(folderOption);
+
+   QDir(root).removeRecursively();
+
+   const auto manager = QLoggerManager::getInstance();
+   manager->setDefaultMaxFileSize(INT_MAX);
+
+   run(QStringLiteral("filtered_out"), root, LogMode::OnlyFile, LogLevel::Error, 1, messages, true);
+   run(QStringLiteral("disabled"), root, LogMode::Disabled, LogLevel::Trace, 1, messages);
+   run(QStringLiteral("memory"), root, LogMode::Memory, LogLevel::Trace, 1, messages);
+   run(QStringLiteral("file_single_producer"), root, LogMode::OnlyFile, LogLevel::Trace, 1, messages);
+   run(QStringLiteral("file_module_handle"), root, LogMode::OnlyFile, LogLevel::Trace, 1, messages, false, true);
+
+   for (auto threads = 2; threads <= maxThreads; threads *= 2)
+   {
+      run(QString("file_producers_%1").arg(threads), root, LogMode::OnlyFile, LogLevel::Trace, threads,
+          messages / threads);
+   }
+
+   manager->setDefaultFileAccess(LogFileAccess::Persistent);
+   run(QStringLiteral("file_persistent"), root, LogMode::OnlyFile, LogLevel::Trace, 1, messages);
+   manager->setDefaultFileAccess(LogFileAccess::OpenPerBatch);
+
+   manager->setDefaultConsoleOptions(LogConsoleOption::MessageHandler);
+
+   const auto previousHandler = qInstallMessageHandler(discardMessage);
+   run(QStringLiteral("console_message_handler"), root, LogMode::OnlyConsole, LogLevel::Trace, 1, messages);
+
+   // The console writer is drained before the handler is restored, so none of its lines reach the results
+   manager->flush();
+   qInstallMessageHandler(previousHandler);
+
+   manager->setDefaultConsoleOptions(LogConsoleOptions());
+
+#ifdef Q_OS_UNIX
+   {
+      // The console writes straight to the descriptor, so the terminal is left out by pointing stdout to /dev/null
+      std::fflush(stdout);
+
+      const auto savedStdout = dup(STDOUT_FILENO);
+      const auto null = open("/dev/null", O_WRONLY);
+
+      dup2(null, STDOUT_FILENO);
+      close(null);
+
+      auto result = measure(QStringLiteral("console"), root, LogMode::OnlyConsole, LogLevel::Trace, 1, messages);
+
+      manager->flush();
+      dup2(savedStdout, STDOUT_FILENO);
+      close(savedStdout);
+
+      printResult(result);
+   }
+#endif
+
+   manager->setDefaultMaxFileSize(256 * 1024);
+   run(QStringLiteral("rotation_under_load"), root, LogMode::OnlyFile, LogLevel::Trace, qMin(4, maxThreads),
+       messages / qMin(4, maxThreads));
+
+   QDir(root).removeRecursively();
+
+   return 0;
+}
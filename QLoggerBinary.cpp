@@ -0,0 +1,368 @@
+#include "QLoggerBinary.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+/**
+ * @brief Appends an unsigned LEB128 varint.
+ */
+void writeVarint(quint64 value, QByteArray &out)
+{
+   while (value >= 0x80)
+   {
+      out.append(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+   }
+
+   out.append(static_cast<char>(value));
+}
+
+/**
+ * @brief Maps signed values to unsigned ones so the small negative deltas are encoded in one byte as well.
+ */
+quint64 zigzag(qint64 value)
+{
+   return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+qint64 unzigzag(quint64 value)
+{
+   return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+}
+
+namespace QLogger
+{
+
+void QLoggerBinaryEncoder::writeHeader(QByteArray &out)
+{
+   mLiterals.clear();
+   mStrings.clear();
+   mNextId = 0;
+   mLastTime = 0;
+
+   out.append(QLoggerBinary::Magic, static_cast<int>(std::strlen(QLoggerBinary::Magic)));
+   out.append(QLoggerBinary::Version);
+}
+
+void QLoggerBinaryEncoder::writeRecord(const LogRecord &record, qint64 wallTime, QByteArray &out)
+{
+   // The new strings are defined before the record that uses them
+   const auto module = intern(record.module, out);
+   const auto threadId = intern(record.threadId, out);
+   const auto file = intern(record.file, record.fileName, out);
+   const auto function = intern(record.function, record.functionName, out);
+   const auto time = wallTime / 1000;
+
+   mFieldKeys.resize(0);
+
+   for (const auto &field : record.fields)
+      mFieldKeys.append(intern(field.key, field.keyName, out));
+
+   out.append(record.fields.isEmpty() ? QLoggerBinary::RecordTag : QLoggerBinary::FieldsRecordTag);
+   writeVarint(zigzag(time - mLastTime), out);
+   out.append(static_cast<char>(record.level));
+   writeVarint(module, out);
+   writeVarint(threadId, out);
+   writeVarint(file, out);
+   writeVarint(function, out);
+   writeVarint(static_cast<quint64>(qMax(0, record.line + 1)), out);
+   writeString(record.message.toUtf8(), out);
+
+   if (!record.fields.isEmpty())
+   {
+      writeVarint(static_cast<quint64>(record.fields.size()), out);
+
+      for (auto i = 0; i < record.fields.size(); ++i)
+      {
+         const auto &field = record.fields.at(i);
+
+         writeVarint(mFieldKeys.at(i), out);
+         out.append(static_cast<char>(field.type));
+
+         switch (field.type)
+         {
+            case LogField::Type::Int:
+               writeVarint(zigzag(field.intValue), out);
+               break;
+            case LogField::Type::UInt:
+               writeVarint(field.uintValue, out);
+               break;
+            case LogField::Type::Double:
+            {
+               quint64 bits = 0;
+               std::memcpy(&bits, &field.doubleValue, sizeof(bits));
+
+               for (auto byte = 0; byte < 8; ++byte)
+                  out.append(static_cast<char>((bits >> (8 * byte)) & 0xFF));
+               break;
+            }
+            case LogField::Type::Bool:
+               out.append(field.boolValue ? '\1' : '\0');
+               break;
+            case LogField::Type::String:
+               writeString(field.text.toUtf8(), out);
+               break;
+         }
+      }
+   }
+
+   mLastTime = time;
+}
+
+void QLoggerBinaryEncoder::writeText(const QString &text, QByteArray &out)
+{
+   out.append(QLoggerBinary::TextTag);
+   writeString(text.toUtf8(), out);
+}
+
+quint32 QLoggerBinaryEncoder::intern(const QString &text, QByteArray &out)
+{
+   const auto it = mStrings.constFind(text);
+
+   if (it != mStrings.constEnd())
+      return it.value();
+
+   out.append(QLoggerBinary::StringTag);
+   writeString(text.toUtf8(), out);
+
+   mStrings.insert(text, mNextId);
+
+   return mNextId++;
+}
+
+quint32 QLoggerBinaryEncoder::intern(const char *literal, const QString &text, QByteArray &out)
+{
+   if (!literal)
+      return intern(text, out);
+
+   const auto it = mLiterals.constFind(literal);
+
+   if (it != mLiterals.constEnd())
+      return it.value();
+
+   const auto id = intern(QString::fromUtf8(literal), out);
+
+   mLiterals.insert(literal, id);
+
+   return id;
+}
+
+void QLoggerBinaryEncoder::writeString(const QByteArray &utf8, QByteArray &out)
+{
+   writeVarint(static_cast<quint64>(utf8.size()), out);
+   out.append(utf8);
+}
+
+QLoggerBinaryDecoder::QLoggerBinaryDecoder(const QByteArray &data)
+   : mData(data)
+{
+}
+
+QLoggerBinaryDecoder::Entry QLoggerBinaryDecoder::next(LogRecord &record, QString &text)
+{
+   while (mPosition < mData.size())
+   {
+      switch (mData.at(mPosition))
+      {
+         case QLoggerBinary::HeaderTag:
+         {
+            const auto magicSize = static_cast<int>(std::strlen(QLoggerBinary::Magic));
+
+            if (mData.size() - mPosition <= magicSize
+                || std::memcmp(mData.constData() + mPosition, QLoggerBinary::Magic, magicSize) != 0
+                || mData.at(mPosition + magicSize) != QLoggerBinary::Version)
+            {
+               return Entry::Corrupted;
+            }
+
+            mPosition += magicSize + 1;
+            mStrings.clear();
+            mLastTime = 0;
+            break;
+         }
+         case QLoggerBinary::StringTag:
+         {
+            ++mPosition;
+
+            QString string;
+
+            if (!readUtf8(string))
+               return Entry::Corrupted;
+
+            mStrings.append(string);
+            break;
+         }
+         case QLoggerBinary::TextTag:
+            ++mPosition;
+            return readUtf8(text) ? Entry::Text : Entry::Corrupted;
+         case QLoggerBinary::RecordTag:
+         case QLoggerBinary::FieldsRecordTag:
+         {
+            const auto withFields = mData.at(mPosition++) == QLoggerBinary::FieldsRecordTag;
+
+            return readRecord(record, withFields) ? Entry::Record : Entry::Corrupted;
+         }
+         case '\0':
+         {
+            // The zeros preallocated by LogFileAccess::MemoryMapped end the data of a file that was not closed
+            const auto end = mData.constData() + mData.size();
+
+            if (std::all_of(mData.constData() + mPosition, end, [](char byte) { return byte == '\0'; }))
+            {
+               mPosition = static_cast<int>(mData.size());
+               return Entry::End;
+            }
+
+            return Entry::Corrupted;
+         }
+         default:
+            return Entry::Corrupted;
+      }
+   }
+
+   return Entry::End;
+}
+
+bool QLoggerBinaryDecoder::readRecord(LogRecord &record, bool withFields)
+{
+   quint64 delta = 0;
+   quint64 line = 0;
+
+   if (!readVarint(delta) || mPosition >= mData.size())
+      return false;
+
+   const auto level = static_cast<quint8>(mData.at(mPosition++));
+
+   record = LogRecord();
+
+   if (level > static_cast<quint8>(LogLevel::Fatal) || !readString(record.module) || !readString(record.threadId)
+       || !readString(record.fileName) || !readString(record.functionName) || !readVarint(line)
+       || !readUtf8(record.message))
+   {
+      return false;
+   }
+
+   if (withFields)
+   {
+      quint64 count = 0;
+
+      // Every field takes at least three bytes
+      if (!readVarint(count) || count > static_cast<quint64>(mData.size() - mPosition) / 3)
+         return false;
+
+      record.fields.resize(static_cast<int>(count));
+
+      for (auto &field : record.fields)
+      {
+         if (!readField(field))
+            return false;
+      }
+   }
+
+   mLastTime += unzigzag(delta);
+
+   record.timestamp = mLastTime * 1000;
+   record.level = static_cast<LogLevel>(level);
+   record.line = static_cast<int>(line) - 1;
+
+   return true;
+}
+
+bool QLoggerBinaryDecoder::readField(LogField &field)
+{
+   if (!readString(field.keyName) || mPosition >= mData.size())
+      return false;
+
+   const auto type = static_cast<quint8>(mData.at(mPosition++));
+
+   if (type > static_cast<quint8>(LogField::Type::String))
+      return false;
+
+   field.type = static_cast<LogField::Type>(type);
+
+   switch (field.type)
+   {
+      case LogField::Type::Int:
+      {
+         quint64 value = 0;
+
+         if (!readVarint(value))
+            return false;
+
+         field.intValue = unzigzag(value);
+         return true;
+      }
+      case LogField::Type::UInt:
+         return readVarint(field.uintValue);
+      case LogField::Type::Double:
+      {
+         if (mData.size() - mPosition < 8)
+            return false;
+
+         quint64 bits = 0;
+
+         for (auto byte = 0; byte < 8; ++byte)
+            bits |= static_cast<quint64>(static_cast<quint8>(mData.at(mPosition++))) << (8 * byte);
+
+         std::memcpy(&field.doubleValue, &bits, sizeof(bits));
+         return true;
+      }
+      case LogField::Type::Bool:
+         if (mPosition >= mData.size())
+            return false;
+
+         field.boolValue = mData.at(mPosition++) != 0;
+         return true;
+      case LogField::Type::String:
+         return readUtf8(field.text);
+   }
+
+   return false;
+}
+
+bool QLoggerBinaryDecoder::readVarint(quint64 &value)
+{
+   value = 0;
+
+   for (auto shift = 0; shift < 64 && mPosition < mData.size(); shift += 7)
+   {
+      const auto byte = static_cast<quint8>(mData.at(mPosition++));
+
+      value |= static_cast<quint64>(byte & 0x7F) << shift;
+
+      if (!(byte & 0x80))
+         return true;
+   }
+
+   return false;
+}
+
+bool QLoggerBinaryDecoder::readUtf8(QString &text)
+{
+   quint64 size = 0;
+
+   if (!readVarint(size) || size > static_cast<quint64>(mData.size() - mPosition))
+      return false;
+
+   text = QString::fromUtf8(mData.constData() + mPosition, static_cast<int>(size));
+   mPosition += static_cast<int>(size);
+
+   return true;
+}
+
+bool QLoggerBinaryDecoder::readString(QString &text)
+{
+   quint64 id = 0;
+
+   if (!readVarint(id) || id >= static_cast<quint64>(mStrings.size()))
+      return false;
+
+   text = mStrings.at(static_cast<int>(id));
+
+   return true;
+}
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerRecord.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace QLogger
+{
+
+/**
+ * @brief Layout of the binary log files. A file is a sequence of entries that start with a tag byte:
+ *
+ * - Header: the magic "QLGB" and the version. It is written every time the file is opened, and resets the string
+ *   table.
+ * - String: the UTF-8 bytes of a string prefixed by their length. The strings get consecutive ids from zero.
+ * - Record: the time in microseconds since the previous record (zigzag), the level byte, the ids of the module,
+ *   thread, file and function strings, the line plus one and the UTF-8 bytes of the message prefixed by their
+ *   length.
+ * - Record with fields: a record followed by the amount of fields and, for each of them, the id of the key string,
+ *   the type byte and the value: zigzag integer, unsigned integer, 8 bytes little-endian double, bool byte or UTF-8
+ *   bytes prefixed by their length.
+ * - Text: a line written by QLogger itself, for instance the name of the previous log.
+ *
+ * All the integers are unsigned LEB128 varints.
+ */
+namespace QLoggerBinary
+{
+constexpr char Magic[] = "QLGB";
+constexpr char Version = 1;
+
+enum Tag : char
+{
+   StringTag = 0x01,
+   RecordTag = 0x02,
+   TextTag = 0x03,
+   FieldsRecordTag = 0x04,
+   HeaderTag = Magic[0]
+};
+}
+
+/**
+ * @brief The QLoggerBinaryEncoder class writes log records in the binary format. Each string is written only the
+ * first time it appears in the file.
+ */
+class QLoggerBinaryEncoder
+{
+public:
+   /**
+    * @brief writeHeader Starts a new file: the string table is cleared and the header is written.
+    * @param out The buffer where the data is appended.
+    */
+   void writeHeader(QByteArray &out);
+
+   /**
+    * @brief writeRecord Writes a record and the strings it uses for the first time.
+    * @param record The record to write.
+    * @param wallTime The time of the record in nanoseconds since epoch.
+    * @param out The buffer where the data is appended.
+    */
+   void writeRecord(const LogRecord &record, qint64 wallTime, QByteArray &out);
+
+   /**
+    * @brief writeText Writes a line that is not a log record.
+    * @param text The line, without the new line.
+    * @param out The buffer where the data is appended.
+    */
+   void writeText(const QString &text, QByteArray &out);
+
+private:
+   /**
+    * @brief The literals of the QLog_* macros are interned by address, so they are not even hashed.
+    */
+   QHash<const char *, quint32> mLiterals;
+   QHash<QString, quint32> mStrings;
+   quint32 mNextId = 0;
+   qint64 mLastTime = 0;
+   /**
+    * @brief Ids of the keys of the fields of the record being written, kept to reuse the memory.
+    */
+   QVector<quint32> mFieldKeys;
+
+   quint32 intern(const QString &text, QByteArray &out);
+   quint32 intern(const char *literal, const QString &text, QByteArray &out);
+   void writeString(const QByteArray &utf8, QByteArray &out);
+};
+
+/**
+ * @brief The QLoggerBinaryDecoder class reads the entries of a binary log file.
+ */
+class QLoggerBinaryDecoder
+{
+public:
+   enum class Entry
+   {
+      Record,
+      Text,
+      End,
+      /**
+       * @brief The data is truncated or it is not a binary log.
+       */
+      Corrupted
+   };
+
+   explicit QLoggerBinaryDecoder(const QByteArray &data);
+
+   /**
+    * @brief next Reads the next record or text line. The headers and string definitions are consumed on the way.
+    * @param record The record read, with the timestamp in nanoseconds since epoch.
+    * @param text The text line read.
+    * @return What has been read.
+    */
+   Entry next(LogRecord &record, QString &text);
+
+private:
+   const QByteArray mData;
+   int mPosition = 0;
+   QVector<QString> mStrings;
+   qint64 mLastTime = 0;
+
+   bool readVarint(quint64 &value);
+   bool readUtf8(QString &text);
+   bool readString(QString &text);
+   bool readRecord(LogRecord &record, bool withFields);
+   bool readField(LogField &field);
+};
+
+}
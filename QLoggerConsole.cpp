@@ -0,0 +1,154 @@
+#include "QLoggerConsole.h"
+
+#include <QDebug>
+
+#include <cerrno>
+#include <climits>
+
+#ifdef Q_OS_WIN
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+namespace
+{
+/**
+ * @brief Gets the ANSI escape sequence of the color of a level.
+ */
+const char *levelColor(QLogger::LogLevel level)
+{
+   switch (level)
+   {
+      case QLogger::LogLevel::Trace:
+         return "\x1b[90m";
+      case QLogger::LogLevel::Debug:
+         return "\x1b[36m";
+      case QLogger::LogLevel::Info:
+         return "\x1b[32m";
+      case QLogger::LogLevel::Warning:
+         return "\x1b[33m";
+      case QLogger::LogLevel::Error:
+         return "\x1b[31m";
+      case QLogger::LogLevel::Fatal:
+         return "\x1b[1;31m";
+   }
+
+   return "";
+}
+
+/**
+ * @brief Writes the whole data to a file descriptor, retrying the partial and interrupted writes.
+ */
+void writeAll(int fd, const char *data, qint64 size)
+{
+   while (size > 0)
+   {
+#ifdef Q_OS_WIN
+      const auto chunk = static_cast<unsigned int>(qMin<qint64>(size, INT_MAX));
+      const auto written = static_cast<qint64>(_write(fd, data, chunk));
+#else
+      const auto written = static_cast<qint64>(::write(fd, data, static_cast<size_t>(size)));
+#endif
+
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+
+         // Nothing else can be done if the console is gone
+         return;
+      }
+
+      data += written;
+      size -= written;
+   }
+}
+}
+
+namespace QLogger
+{
+
+void QLoggerConsole::write(const QVector<LogRecord> &records, QLoggerFormatter &formatter)
+{
+   for (const auto &record : records)
+      appendMessage(formatter, record);
+
+   flush();
+}
+
+void QLoggerConsole::appendMessage(QLoggerFormatter &formatter, const LogRecord &record)
+{
+   if (mOptions.testFlag(LogConsoleOption::MessageHandler))
+   {
+      qInfo() << formatter.formatMessage(record);
+      return;
+   }
+
+   auto &out = buffer(record.level);
+   const auto start = out.size();
+
+   beginColor(record.level, out);
+   formatter.appendMessage(record, out);
+   endColor(static_cast<int>(start), out);
+}
+
+void QLoggerConsole::appendLine(LogLevel level, const char *line, int size)
+{
+   if (mOptions.testFlag(LogConsoleOption::MessageHandler))
+   {
+      qInfo() << QString::fromUtf8(line, size);
+      return;
+   }
+
+   auto &out = buffer(level);
+   const auto start = out.size();
+
+   beginColor(level, out);
+   out.append(line, size);
+   endColor(static_cast<int>(start), out);
+}
+
+void QLoggerConsole::flush()
+{
+   // The capacity is kept for the next batches
+   if (!mStdout.isEmpty())
+   {
+      writeAll(1, mStdout.constData(), mStdout.size());
+      mStdout.resize(0);
+   }
+
+   if (!mStderr.isEmpty())
+   {
+      writeAll(2, mStderr.constData(), mStderr.size());
+      mStderr.resize(0);
+   }
+}
+
+QByteArray &QLoggerConsole::buffer(LogLevel level)
+{
+   return mOptions.testFlag(LogConsoleOption::ErrorsToStderr) && level >= LogLevel::Error ? mStderr : mStdout;
+}
+
+void QLoggerConsole::beginColor(LogLevel level, QByteArray &out) const
+{
+   if (mOptions.testFlag(LogConsoleOption::Colors))
+      out.append(levelColor(level));
+}
+
+void QLoggerConsole::endColor(int start, QByteArray &out) const
+{
+   if (!mOptions.testFlag(LogConsoleOption::Colors) || out.size() == start)
+      return;
+
+   // The color is reset before the new line
+   if (out.endsWith('\n'))
+   {
+      out.chop(1);
+      out.append("\x1b[0m\n");
+   }
+   else
+      out.append("\x1b[0m");
+}
+
+}
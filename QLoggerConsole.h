@@ -0,0 +1,101 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerFormatter.h>
+#include <QLoggerLevel.h>
+#include <QLoggerRecord.h>
+#include <QLoggerSink.h>
+
+#include <QByteArray>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerConsole class is the built-in sink that writes the messages of a writer in the console. The lines
+ * of a batch are gathered per stream and written with a single write call, without going through the Qt message
+ * handler.
+ */
+class QLoggerConsole : public QLoggerSink
+{
+public:
+   /**
+    * @brief getOptions Gets how the messages are written in the console.
+    * @return The options
+    */
+   LogConsoleOptions getOptions() const { return mOptions; }
+
+   /**
+    * @brief setOptions Sets how the messages are written in the console.
+    * @param options The options
+    */
+   void setOptions(LogConsoleOptions options) { mOptions = options; }
+
+   /**
+    * @brief write Renders the records and writes them.
+    */
+   void write(const QVector<LogRecord> &records, QLoggerFormatter &formatter) override;
+
+   /**
+    * @brief appendMessage Renders the line of a record at the end of the buffer of its stream.
+    * @param formatter The formatter with the layout of the writer.
+    * @param record The record to write.
+    */
+   void appendMessage(QLoggerFormatter &formatter, const LogRecord &record);
+
+   /**
+    * @brief appendLine Copies a line already rendered at the end of the buffer of its stream.
+    * @param level The level of the message, to choose the stream and the color.
+    * @param line The line, ended by a new line.
+    * @param size The size of the line in bytes.
+    */
+   void appendLine(LogLevel level, const char *line, int size);
+
+   /**
+    * @brief flush Writes the buffered lines, one write call per stream.
+    */
+   void flush() override;
+
+private:
+   LogConsoleOptions mOptions;
+   QByteArray mStdout;
+   QByteArray mStderr;
+
+   /**
+    * @brief buffer Gets the buffer of the stream where a message of the given level is written.
+    */
+   QByteArray &buffer(LogLevel level);
+
+   /**
+    * @brief beginColor Appends the color of the level, if colors are enabled.
+    */
+   void beginColor(LogLevel level, QByteArray &out) const;
+
+   /**
+    * @brief endColor Resets the color before the new line that ends the line starting at the given position.
+    */
+   void endColor(int start, QByteArray &out) const;
+};
+
+}
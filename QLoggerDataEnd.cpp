@@ -0,0 +1,72 @@
+#include "QLoggerDataEnd.h"
+
+#include <cstring>
+
+namespace QLogger
+{
+
+bool QLoggerDataEnd::read(const QString &logFile, qint64 &end)
+{
+   QFile file(markerPath(logFile));
+
+   if (!file.open(QIODevice::ReadOnly))
+      return false;
+
+   const auto data = file.read(sizeof(qint64));
+
+   if (data.size() != static_cast<int>(sizeof(qint64)))
+      return false;
+
+   // Written by the same machine, in its own byte order
+   std::memcpy(&end, data.constData(), sizeof(end));
+
+   return end >= 0;
+}
+
+bool QLoggerDataEndWriter::open(const QString &logFile, qint64 end)
+{
+   close();
+
+   mFile.setFileName(QLoggerDataEnd::markerPath(logFile));
+
+   if (!mFile.open(QIODevice::ReadWrite | QIODevice::Truncate) || !mFile.resize(sizeof(qint64)))
+   {
+      close();
+      return false;
+   }
+
+   mData = mFile.map(0, sizeof(qint64));
+
+   if (!mData)
+   {
+      close();
+      return false;
+   }
+
+   store(end);
+
+   return true;
+}
+
+void QLoggerDataEndWriter::store(qint64 end)
+{
+   if (mData)
+      std::memcpy(mData, &end, sizeof(end));
+}
+
+void QLoggerDataEndWriter::close()
+{
+   if (mData)
+   {
+      mFile.unmap(mData);
+      mData = nullptr;
+   }
+
+   if (mFile.isOpen())
+   {
+      mFile.close();
+      mFile.remove();
+   }
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QFile>
+#include <QString>
+
+namespace QLogger
+{
+
+namespace QLoggerDataEnd
+{
+/**
+ * @brief markerPath Gets the path of the marker kept alongside a memory-mapped log file while it is open.
+ */
+inline QString markerPath(const QString &logFile)
+{
+   return logFile + QStringLiteral(".end");
+}
+
+/**
+ * @brief read Reads the end of the data of a memory-mapped log file. The marker only exists while the file is open,
+ * or after a crash of its writer: the preallocated bytes after that end are not part of the log.
+ * @param logFile The log file.
+ * @param end Set to the size of the data.
+ * @return True if the file has a valid marker, false if it is not mapped and has no preallocated bytes.
+ */
+bool read(const QString &logFile, qint64 &end);
+}
+
+/**
+ * @brief The QLoggerDataEndWriter class keeps the marker of a memory-mapped log file up to date. The marker is mapped
+ * as well, so the end of the data is saved by a single store that survives a crash of the process, and it is removed
+ * once the log file has been truncated to its data.
+ */
+class QLoggerDataEndWriter
+{
+public:
+   /**
+    * @brief open Creates the marker of a log file. It must exist before the file is preallocated.
+    * @param logFile The log file.
+    * @param end The current size of the data.
+    * @return True if the marker has been created, otherwise false.
+    */
+   bool open(const QString &logFile, qint64 end);
+
+   /**
+    * @brief store Saves the size of the data.
+    */
+   void store(qint64 end);
+
+   /**
+    * @brief close Removes the marker, once the log file has no preallocated bytes anymore.
+    */
+   void close();
+
+private:
+   QFile mFile;
+   uchar *mData = nullptr;
+};
+
+}
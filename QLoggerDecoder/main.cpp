@@ -0,0 +1,176 @@
+#include <QLoggerBinary.h>
+#include <QLoggerDataEnd.h>
+#include <QLoggerFormatter.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFile>
+
+#include <cstdio>
+
+using namespace QLogger;
+
+namespace
+{
+/**
+ * @brief Converts the name given in the command line into a timestamp format.
+ */
+bool timestampFormatFromText(const QString &text, LogTimestampFormat &timestampFormat)
+{
+   if (text == QLatin1String("seconds"))
+      timestampFormat = LogTimestampFormat::EpochSeconds;
+   else if (text == QLatin1String("millis"))
+      timestampFormat = LogTimestampFormat::EpochMillis;
+   else if (text == QLatin1String("micros"))
+      timestampFormat = LogTimestampFormat::EpochMicros;
+   else if (text == QLatin1String("iso8601"))
+      timestampFormat = LogTimestampFormat::Iso8601Millis;
+   else
+      return false;
+
+   return true;
+}
+
+/**
+ * @brief Converts the name given in the command line into message options.
+ */
+bool messageOptionsFromText(const QString &text, LogMessageDisplays &messageOptions)
+{
+   if (text == QLatin1String("default"))
+      messageOptions = LogMessageDisplay::Default;
+   else if (text == QLatin1String("default2"))
+      messageOptions = LogMessageDisplay::Default2;
+   else if (text == QLatin1String("full"))
+      messageOptions = LogMessageDisplay::Full;
+   else
+      return false;
+
+   return true;
+}
+
+/**
+ * @brief Converts the name given in the command line into the layout of the lines.
+ */
+bool formatFromText(const QString &text, LogFileFormat &format)
+{
+   if (text == QLatin1String("text"))
+      format = LogFileFormat::Text;
+   else if (text == QLatin1String("jsonlines"))
+      format = LogFileFormat::JsonLines;
+   else if (text == QLatin1String("logfmt"))
+      format = LogFileFormat::Logfmt;
+   else
+      return false;
+
+   return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+   QCoreApplication app(argc, argv);
+   QCoreApplication::setApplicationName(QStringLiteral("QLoggerDecoder"));
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription(
+       QStringLiteral("Converts a binary QLogger file into its text layout, JSON lines or logfmt."));
+   parser.addHelpOption();
+
+   const QCommandLineOption timestampOption(QStringLiteral("timestamp"),
+                                            QStringLiteral("Timestamp format: seconds, millis, micros or iso8601."),
+                                            QStringLiteral("format"), QStringLiteral("seconds"));
+   const QCommandLineOption displayOption(QStringLiteral("display"),
+                                          QStringLiteral("Message elements: default, default2 or full."),
+                                          QStringLiteral("options"), QStringLiteral("default"));
+   const QCommandLineOption formatOption(QStringLiteral("format"),
+                                         QStringLiteral("Layout of the lines: text, jsonlines or logfmt."),
+                                         QStringLiteral("format"), QStringLiteral("text"));
+   const QCommandLineOption sourceOption(
+       QStringLiteral("source"),
+       QStringLiteral("Display the file, line and function, as the writers with Debug or Trace level do."));
+
+   parser.addOption(timestampOption);
+   parser.addOption(displayOption);
+   parser.addOption(formatOption);
+   parser.addOption(sourceOption);
+   parser.addPositionalArgument(QStringLiteral("input"), QStringLiteral("The binary log file."));
+   parser.addPositionalArgument(QStringLiteral("output"), QStringLiteral("The text file, standard output if empty."));
+   parser.process(app);
+
+   const auto arguments = parser.positionalArguments();
+   auto timestampFormat = LogTimestampFormat::EpochSeconds;
+   LogMessageDisplays messageOptions = LogMessageDisplay::Default;
+   auto format = LogFileFormat::Text;
+
+   if (arguments.isEmpty() || !timestampFormatFromText(parser.value(timestampOption), timestampFormat)
+       || !messageOptionsFromText(parser.value(displayOption), messageOptions)
+       || !formatFromText(parser.value(formatOption), format))
+   {
+      parser.showHelp(1);
+   }
+
+   QFile input(arguments.at(0));
+
+   if (!input.open(QIODevice::ReadOnly))
+   {
+      qCritical() << "Could not open" << input.fileName();
+      return 1;
+   }
+
+   QFile output;
+   auto opened = false;
+
+   if (arguments.count() > 1)
+   {
+      output.setFileName(arguments.at(1));
+      opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+   }
+   else
+      opened = output.open(stdout, QIODevice::WriteOnly);
+
+   if (!opened)
+   {
+      qCritical() << "Could not open the output";
+      return 1;
+   }
+
+   const auto sourceLocation = parser.isSet(sourceOption);
+
+   // The decoded timestamps are already in wall time, so the clock offset of the formatter stays at zero
+   QLoggerFormatter formatter;
+   formatter.setLayout(messageOptions, timestampFormat, sourceLocation, format);
+
+   auto data = input.readAll();
+   qint64 dataEnd = 0;
+
+   // A file still mapped by its writer, or left by a crash, is preallocated after its data
+   if (QLoggerDataEnd::read(input.fileName(), dataEnd) && dataEnd < data.size())
+      data.truncate(static_cast<int>(dataEnd));
+
+   QLoggerBinaryDecoder decoder(data);
+   LogRecord record;
+   QString text;
+   QByteArray line;
+
+   while (true)
+   {
+      switch (decoder.next(record, text))
+      {
+         case QLoggerBinaryDecoder::Entry::Record:
+            line.resize(0);
+            formatter.appendMessage(record, line);
+            output.write(line);
+            break;
+         case QLoggerBinaryDecoder::Entry::Text:
+            output.write(text.toUtf8());
+            output.write("\n", 1);
+            break;
+         case QLoggerBinaryDecoder::Entry::End:
+            return 0;
+         case QLoggerBinaryDecoder::Entry::Corrupted:
+            qCritical() << "Corrupted data in" << input.fileName();
+            return 2;
+      }
+   }
+}
@@ -0,0 +1,763 @@
+#include "QLoggerFormatter.h"
+
+#include <QDateTime>
+
+#include <QLocale>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+using QLogger::LogField;
+using QLogger::LogRecord;
+
+/**
+ * @brief Gets the file name without the path.
+ * @param file The path given by __FILE__.
+ * @return A pointer to the file name inside the same string.
+ */
+const char *baseName(const char *file)
+{
+   const auto slash = std::strrchr(file, '/');
+
+   return slash ? slash + 1 : file;
+}
+
+/**
+ * @brief Gets the name of a level as a literal.
+ */
+const char *levelName(QLogger::LogLevel level)
+{
+   switch (level)
+   {
+      case QLogger::LogLevel::Trace:
+         return "Trace";
+      case QLogger::LogLevel::Debug:
+         return "Debug";
+      case QLogger::LogLevel::Info:
+         return "Info";
+      case QLogger::LogLevel::Warning:
+         return "Warning";
+      case QLogger::LogLevel::Error:
+         return "Error";
+      case QLogger::LogLevel::Fatal:
+         return "Fatal";
+   }
+
+   return "";
+}
+
+/**
+ * @brief Appends the decimal digits of a number, without building a string.
+ */
+void appendUnsigned(quint64 value, QByteArray &out, int minDigits = 1)
+{
+   char digits[24];
+   auto end = digits + sizeof(digits);
+   auto begin = end;
+
+   do
+   {
+      *--begin = static_cast<char>('0' + value % 10);
+      value /= 10;
+   } while (value > 0 || end - begin < minDigits);
+
+   out.append(begin, static_cast<int>(end - begin));
+}
+
+void appendNumber(qint64 value, QByteArray &out, int minDigits = 1)
+{
+   if (value < 0)
+   {
+      out.append('-');
+      appendUnsigned(0 - static_cast<quint64>(value), out, minDigits);
+   }
+   else
+      appendUnsigned(static_cast<quint64>(value), out, minDigits);
+}
+
+/**
+ * @brief Appends the shortest text that gives back the same double. JSON has no text for NaN and infinity, so they
+ * are written as null there.
+ */
+void appendDouble(double value, QByteArray &out, bool json)
+{
+   if (json && !std::isfinite(value))
+      out.append("null", 4);
+   else
+      out.append(QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+}
+
+/**
+ * @brief Checks if a byte has to be escaped inside a JSON or a quoted logfmt string.
+ */
+bool needsEscape(char byte)
+{
+   return static_cast<uchar>(byte) < 0x20 || byte == '"' || byte == '\\';
+}
+
+/**
+ * @brief Escapes the bytes appended to a buffer since the given position. The usual text has nothing to escape, so
+ * the bytes are only copied again when needed.
+ */
+void escapeFrom(int start, QByteArray &out)
+{
+   if (std::none_of(out.constData() + start, out.constData() + out.size(), needsEscape))
+      return;
+
+   const auto raw = out.mid(start);
+   out.resize(start);
+
+   for (const auto byte : raw)
+   {
+      switch (byte)
+      {
+         case '"':
+            out.append("\\\"", 2);
+            break;
+         case '\\':
+            out.append("\\\\", 2);
+            break;
+         case '\n':
+            out.append("\\n", 2);
+            break;
+         case '\r':
+            out.append("\\r", 2);
+            break;
+         case '\t':
+            out.append("\\t", 2);
+            break;
+         default:
+            if (needsEscape(byte))
+            {
+               out.append("\\u00", 4);
+               out.append("0123456789abcdef"[(byte >> 4) & 0xF]);
+               out.append("0123456789abcdef"[byte & 0xF]);
+            }
+            else
+               out.append(byte);
+            break;
+      }
+   }
+}
+
+/**
+ * @brief Quotes and escapes the logfmt value appended since the given position, if it is empty or it has spaces,
+ * equal signs, quotes or control characters.
+ */
+void quoteFrom(int start, QByteArray &out)
+{
+   const auto needsQuotes = [](char byte) { return byte == ' ' || byte == '=' || needsEscape(byte); };
+
+   if (out.size() != start && std::none_of(out.constData() + start, out.constData() + out.size(), needsQuotes))
+      return;
+
+   const auto raw = out.mid(start);
+   out.resize(start);
+   out.append('"');
+   out.append(raw);
+   escapeFrom(start + 1, out);
+   out.append('"');
+}
+
+void encodeUtf8(const QChar *chars, int size, QByteArray &out)
+{
+   const auto start = out.size();
+
+   // Three bytes are enough for any UTF-16 unit, and a surrogate pair takes four bytes for two units
+   out.resize(start + size * 3);
+
+   auto dst = reinterpret_cast<uchar *>(out.data()) + start;
+
+   for (auto i = 0; i < size; ++i)
+   {
+      const auto unit = chars[i].unicode();
+
+      if (unit < 0x80)
+         *dst++ = static_cast<uchar>(unit);
+      else if (unit < 0x800)
+      {
+         *dst++ = static_cast<uchar>(0xC0 | (unit >> 6));
+         *dst++ = static_cast<uchar>(0x80 | (unit & 0x3F));
+      }
+      else if (QChar::isHighSurrogate(unit) && i + 1 < size && QChar::isLowSurrogate(chars[i + 1].unicode()))
+      {
+         const auto ucs4 = QChar::surrogateToUcs4(unit, chars[++i].unicode());
+
+         *dst++ = static_cast<uchar>(0xF0 | (ucs4 >> 18));
+         *dst++ = static_cast<uchar>(0x80 | ((ucs4 >> 12) & 0x3F));
+         *dst++ = static_cast<uchar>(0x80 | ((ucs4 >> 6) & 0x3F));
+         *dst++ = static_cast<uchar>(0x80 | (ucs4 & 0x3F));
+      }
+      else
+      {
+         // A lone surrogate is replaced by U+FFFD, as QString::toUtf8 does
+         const auto code = QChar::isHighSurrogate(unit) || QChar::isLowSurrogate(unit) ? 0xFFFD : unit;
+
+         *dst++ = static_cast<uchar>(0xE0 | (code >> 12));
+         *dst++ = static_cast<uchar>(0x80 | ((code >> 6) & 0x3F));
+         *dst++ = static_cast<uchar>(0x80 | (code & 0x3F));
+      }
+   }
+
+   out.resize(static_cast<int>(dst - reinterpret_cast<const uchar *>(out.constData())));
+}
+
+/**
+ * @brief The SourceFile struct points to the file name of a record without the path, in the literal of the macros or
+ * in the QString given instead.
+ */
+struct SourceFile
+{
+   const char *literal = nullptr;
+   const QChar *chars = nullptr;
+   int size = 0;
+};
+
+SourceFile sourceFile(const LogRecord &record)
+{
+   SourceFile file;
+
+   if (record.file)
+   {
+      file.literal = baseName(record.file);
+      file.size = static_cast<int>(std::strlen(file.literal));
+   }
+   else
+   {
+      const auto start = record.fileName.lastIndexOf(QLatin1Char('/')) + 1;
+
+      file.chars = record.fileName.constData() + start;
+      file.size = static_cast<int>(record.fileName.size() - start);
+   }
+
+   return file;
+}
+
+void appendSourceFile(const SourceFile &file, QByteArray &out)
+{
+   if (file.literal)
+      out.append(file.literal, file.size);
+   else
+      encodeUtf8(file.chars, file.size, out);
+}
+
+bool hasFunction(const LogRecord &record)
+{
+   return record.function ? record.function[0] != '\0' : !record.functionName.isEmpty();
+}
+
+void appendFunction(const LogRecord &record, QByteArray &out)
+{
+   if (record.function)
+      out.append(record.function, static_cast<int>(std::strlen(record.function)));
+   else
+      encodeUtf8(record.functionName.constData(), static_cast<int>(record.functionName.size()), out);
+}
+
+void appendKey(const LogField &field, QByteArray &out)
+{
+   if (field.key)
+      out.append(field.key, static_cast<int>(std::strlen(field.key)));
+   else
+      encodeUtf8(field.keyName.constData(), static_cast<int>(field.keyName.size()), out);
+}
+
+/**
+ * @brief Appends a text as a JSON string.
+ */
+void appendJsonString(const QString &text, QByteArray &out)
+{
+   out.append('"');
+
+   const auto start = static_cast<int>(out.size());
+
+   encodeUtf8(text.constData(), static_cast<int>(text.size()), out);
+   escapeFrom(start, out);
+   out.append('"');
+}
+
+/**
+ * @brief Appends a text as a logfmt value, quoted only if needed.
+ */
+void appendLogfmtString(const QString &text, QByteArray &out)
+{
+   const auto start = static_cast<int>(out.size());
+
+   encodeUtf8(text.constData(), static_cast<int>(text.size()), out);
+   quoteFrom(start, out);
+}
+
+/**
+ * @brief Appends the fields of a record as logfmt pairs, each of them after a space.
+ */
+void appendLogfmtFields(const QVector<LogField> &fields, QByteArray &out)
+{
+   for (const auto &field : fields)
+   {
+      out.append(' ');
+      appendKey(field, out);
+      out.append('=');
+
+      switch (field.type)
+      {
+         case LogField::Type::Int:
+            appendNumber(field.intValue, out);
+            break;
+         case LogField::Type::UInt:
+            appendUnsigned(field.uintValue, out);
+            break;
+         case LogField::Type::Double:
+            appendDouble(field.doubleValue, out, false);
+            break;
+         case LogField::Type::Bool:
+            out.append(field.boolValue ? "true" : "false");
+            break;
+         case LogField::Type::String:
+            appendLogfmtString(field.text, out);
+            break;
+      }
+   }
+}
+
+/**
+ * @brief Appends the fields of a record as JSON members, each of them after a comma.
+ */
+void appendJsonFields(const QVector<LogField> &fields, QByteArray &out)
+{
+   for (const auto &field : fields)
+   {
+      out.append(",\"", 2);
+
+      const auto start = static_cast<int>(out.size());
+
+      appendKey(field, out);
+      escapeFrom(start, out);
+      out.append("\":", 2);
+
+      switch (field.type)
+      {
+         case LogField::Type::Int:
+            appendNumber(field.intValue, out);
+            break;
+         case LogField::Type::UInt:
+            appendUnsigned(field.uintValue, out);
+            break;
+         case LogField::Type::Double:
+            appendDouble(field.doubleValue, out, true);
+            break;
+         case LogField::Type::Bool:
+            out.append(field.boolValue ? "true" : "false");
+            break;
+         case LogField::Type::String:
+            appendJsonString(field.text, out);
+            break;
+      }
+   }
+}
+}
+
+namespace QLogger
+{
+
+QString QLoggerFormatter::levelToText(LogLevel level)
+{
+   return QString::fromLatin1(levelName(level));
+}
+
+void QLoggerFormatter::updateClockOffset()
+{
+   const auto wallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+
+   mClockOffset = wallTime - LogRecord::currentTimestamp();
+}
+
+void QLoggerFormatter::setLayout(LogMessageDisplays messageOptions, LogTimestampFormat timestampFormat,
+                                 bool sourceLocation, LogFileFormat format)
+{
+   if (mHasLayout && messageOptions == mMessageOptions && timestampFormat == mTimestampFormat
+       && sourceLocation == mSourceLocation && format == mFormat)
+   {
+      return;
+   }
+
+   mHasLayout = true;
+   mMessageOptions = messageOptions;
+   mTimestampFormat = timestampFormat;
+   mSourceLocation = sourceLocation;
+   mFormat = format;
+
+   const auto file = sourceLocation && messageOptions.testFlag(LogMessageDisplay::File);
+
+   mSourceLine = file && messageOptions.testFlag(LogMessageDisplay::Line);
+   mSourceFunction = file && messageOptions.testFlag(LogMessageDisplay::Function);
+
+   mFields.clear();
+
+   if (messageOptions.testFlag(LogMessageDisplay::LogLevel))
+      mFields.append(Field::LogLevel);
+
+   if (messageOptions.testFlag(LogMessageDisplay::ModuleName))
+      mFields.append(Field::ModuleName);
+
+   if (messageOptions.testFlag(LogMessageDisplay::DateTime))
+      mFields.append(Field::DateTime);
+
+   if (messageOptions.testFlag(LogMessageDisplay::ThreadId))
+      mFields.append(Field::ThreadId);
+
+   if (mSourceLine || mSourceFunction)
+      mFields.append(Field::Source);
+
+   if (messageOptions.testFlag(LogMessageDisplay::Message))
+      mFields.append(Field::Message);
+}
+
+void QLoggerFormatter::appendTimestamp(qint64 timestamp, QByteArray &out)
+{
+   const auto microsSinceEpoch = (timestamp + mClockOffset) / 1000;
+
+   switch (mTimestampFormat)
+   {
+      case LogTimestampFormat::EpochSeconds:
+         appendNumber(microsSinceEpoch / 1000000, out);
+         return;
+      case LogTimestampFormat::EpochMillis:
+         appendNumber(microsSinceEpoch / 1000, out);
+         return;
+      case LogTimestampFormat::EpochMicros:
+         appendNumber(microsSinceEpoch, out);
+         return;
+      case LogTimestampFormat::Iso8601Millis:
+         break;
+   }
+
+   const auto msecsSinceEpoch = microsSinceEpoch / 1000;
+   const auto secsSinceEpoch = msecsSinceEpoch / 1000;
+
+   // Only the milliseconds change between the messages of the same second
+   if (secsSinceEpoch != mCachedSecond)
+   {
+      mCachedSecond = secsSinceEpoch;
+      mCachedSecondText = QDateTime::fromMSecsSinceEpoch(secsSinceEpoch * 1000, Qt::UTC)
+                              .toString(QStringLiteral("yyyy-MM-ddTHH:mm:ss"))
+                              .toLatin1();
+   }
+
+   out.append(mCachedSecondText);
+   out.append('.');
+   appendNumber(msecsSinceEpoch % 1000, out, 3);
+   out.append('Z');
+}
+
+QLoggerFormatter::Source QLoggerFormatter::sourceOf(const LogRecord &record) const
+{
+   if (mSourceLine && record.line > 0)
+      return Source::Line;
+
+   if (mSourceFunction && hasFunction(record))
+      return Source::Function;
+
+   return Source::None;
+}
+
+void QLoggerFormatter::appendSource(const LogRecord &record, QByteArray &out) const
+{
+   const auto source = sourceOf(record);
+   const auto file = sourceFile(record);
+
+   if (source == Source::None || file.size == 0)
+      return;
+
+   out.append('{');
+   appendSourceFile(file, out);
+
+   if (source == Source::Line)
+   {
+      out.append(':');
+      appendNumber(record.line, out);
+   }
+   else
+   {
+      out.append("}{", 2);
+      appendFunction(record, out);
+   }
+
+   out.append('}');
+}
+
+void QLoggerFormatter::appendMessage(const LogRecord &record, QByteArray &out)
+{
+   switch (mFormat)
+   {
+      case LogFileFormat::JsonLines:
+         appendJson(record, out);
+         break;
+      case LogFileFormat::Logfmt:
+         appendLogfmt(record, out);
+         break;
+      case LogFileFormat::Text:
+      case LogFileFormat::Binary:
+         appendText(record, out);
+         break;
+   }
+}
+
+void QLoggerFormatter::appendText(const LogRecord &record, QByteArray &out)
+{
+   const auto start = out.size();
+
+   for (const auto field : std::as_const(mFields))
+   {
+      switch (field)
+      {
+         case Field::LogLevel:
+            out.append('[');
+            out.append(levelName(record.level));
+            out.append(']');
+            break;
+         case Field::ModuleName:
+            out.append('[');
+            appendUtf8(record.module, out);
+            out.append(']');
+            break;
+         case Field::DateTime:
+            out.append('[');
+            appendTimestamp(record.timestamp, out);
+            out.append(']');
+            break;
+         case Field::ThreadId:
+            out.append('[');
+            appendUtf8(record.threadId, out);
+            out.append(']');
+            break;
+         case Field::Source:
+            appendSource(record, out);
+            break;
+         case Field::Message:
+            if (out.size() != start)
+               out.append(' ');
+
+            appendUtf8(record.message, out);
+            break;
+      }
+   }
+
+   // The fields follow the message as logfmt pairs
+   if (!record.fields.isEmpty())
+   {
+      const auto fieldsStart = out.size();
+
+      appendLogfmtFields(record.fields, out);
+
+      if (fieldsStart == start)
+         out.remove(static_cast<int>(start), 1);
+   }
+
+   out.append('\n');
+}
+
+void QLoggerFormatter::appendLogfmt(const LogRecord &record, QByteArray &out)
+{
+   const auto start = out.size();
+   const auto separate = [&]() {
+      if (out.size() != start)
+         out.append(' ');
+   };
+
+   for (const auto field : std::as_const(mFields))
+   {
+      switch (field)
+      {
+         case Field::LogLevel:
+            separate();
+            out.append("level=", 6);
+            out.append(levelName(record.level));
+            break;
+         case Field::ModuleName:
+            separate();
+            out.append("module=", 7);
+            appendLogfmtString(record.module, out);
+            break;
+         case Field::DateTime:
+            separate();
+            out.append("time=", 5);
+            appendTimestamp(record.timestamp, out);
+            break;
+         case Field::ThreadId:
+            separate();
+            out.append("thread=", 7);
+            appendLogfmtString(record.threadId, out);
+            break;
+         case Field::Source:
+         {
+            const auto source = sourceOf(record);
+            const auto file = sourceFile(record);
+
+            if (source == Source::None || file.size == 0)
+               break;
+
+            separate();
+            out.append("file=", 5);
+
+            auto valueStart = static_cast<int>(out.size());
+
+            appendSourceFile(file, out);
+            quoteFrom(valueStart, out);
+
+            if (source == Source::Line)
+            {
+               out.append(" line=", 6);
+               appendNumber(record.line, out);
+            }
+            else
+            {
+               out.append(" function=", 10);
+               valueStart = static_cast<int>(out.size());
+               appendFunction(record, out);
+               quoteFrom(valueStart, out);
+            }
+            break;
+         }
+         case Field::Message:
+            separate();
+            out.append("msg=", 4);
+            appendLogfmtString(record.message, out);
+            break;
+      }
+   }
+
+   if (!record.fields.isEmpty())
+   {
+      const auto fieldsStart = out.size();
+
+      appendLogfmtFields(record.fields, out);
+
+      if (fieldsStart == start)
+         out.remove(static_cast<int>(start), 1);
+   }
+
+   out.append('\n');
+}
+
+void QLoggerFormatter::appendJson(const LogRecord &record, QByteArray &out)
+{
+   out.append('{');
+
+   const auto start = out.size();
+   const auto key = [&](const char *name) {
+      if (out.size() != start)
+         out.append(',');
+
+      out.append('"');
+      out.append(name);
+      out.append("\":", 2);
+   };
+
+   for (const auto field : std::as_const(mFields))
+   {
+      switch (field)
+      {
+         case Field::LogLevel:
+            key("level");
+            out.append('"');
+            out.append(levelName(record.level));
+            out.append('"');
+            break;
+         case Field::ModuleName:
+            key("module");
+            appendJsonString(record.module, out);
+            break;
+         case Field::DateTime:
+         {
+            // The epoch timestamps are numbers, the ISO 8601 ones are strings
+            const auto quoted = mTimestampFormat == LogTimestampFormat::Iso8601Millis;
+
+            key("time");
+
+            if (quoted)
+               out.append('"');
+
+            appendTimestamp(record.timestamp, out);
+
+            if (quoted)
+               out.append('"');
+            break;
+         }
+         case Field::ThreadId:
+            key("thread");
+            appendJsonString(record.threadId, out);
+            break;
+         case Field::Source:
+         {
+            const auto source = sourceOf(record);
+            const auto file = sourceFile(record);
+
+            if (source == Source::None || file.size == 0)
+               break;
+
+            key("file");
+            out.append('"');
+
+            auto valueStart = static_cast<int>(out.size());
+
+            appendSourceFile(file, out);
+            escapeFrom(valueStart, out);
+            out.append('"');
+
+            if (source == Source::Line)
+            {
+               key("line");
+               appendNumber(record.line, out);
+            }
+            else
+            {
+               key("function");
+               out.append('"');
+               valueStart = static_cast<int>(out.size());
+               appendFunction(record, out);
+               escapeFrom(valueStart, out);
+               out.append('"');
+            }
+            break;
+         }
+         case Field::Message:
+            key("message");
+            appendJsonString(record.message, out);
+            break;
+      }
+   }
+
+   if (!record.fields.isEmpty())
+   {
+      const auto fieldsStart = out.size();
+
+      appendJsonFields(record.fields, out);
+
+      // Without any element before, the comma of the first field is not needed
+      if (fieldsStart == start)
+         out.remove(static_cast<int>(start), 1);
+   }
+
+   out.append("}\n", 2);
+}
+
+QString QLoggerFormatter::formatMessage(const LogRecord &record)
+{
+   mLine.resize(0);
+   appendMessage(record, mLine);
+
+   return QString::fromUtf8(mLine);
+}
+
+void QLoggerFormatter::appendUtf8(const QString &text, QByteArray &out)
+{
+   encodeUtf8(text.constData(), static_cast<int>(text.size()), out);
+}
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerLevel.h>
+#include <QLoggerRecord.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerFormatter class builds the text lines of the log records. It is used by the writer thread and by
+ * the decoder of the binary files, so both produce the same layout. The lines are rendered in UTF-8, straight into the
+ * buffer that is written in the file.
+ */
+class QLoggerFormatter
+{
+public:
+   /**
+    * @brief Converts the given level in a QString.
+    * @param level The log level in LogLevel format.
+    * @return The string with the name of the log level.
+    */
+   static QString levelToText(LogLevel level);
+
+   /**
+    * @brief updateClockOffset Computes the difference between the wall clock and the monotonic clock of the
+    * records. It is done once per batch.
+    */
+   void updateClockOffset();
+
+   /**
+    * @brief setClockOffset Sets the difference between the wall clock and the timestamps of the records. It is zero
+    * when the timestamps are already in wall time.
+    * @param clockOffset The difference in nanoseconds.
+    */
+   void setClockOffset(qint64 clockOffset) { mClockOffset = clockOffset; }
+
+   /**
+    * @brief toWallTime Converts the monotonic time of a record to wall time.
+    * @param timestamp The monotonic time in nanoseconds.
+    * @return The nanoseconds since epoch.
+    */
+   qint64 toWallTime(qint64 timestamp) const { return timestamp + mClockOffset; }
+
+   /**
+    * @brief setLayout Sets the elements displayed in the lines. The fields of the line are only computed again when
+    * one of the values changes, so it can be called once per batch.
+    * @param messageOptions The elements displayed in the line.
+    * @param timestampFormat The timestamp format.
+    * @param sourceLocation Whether the file, line and function can be displayed.
+    * @param format The layout of the line: text, JSON or logfmt. The binary format gets the text lines.
+    */
+   void setLayout(LogMessageDisplays messageOptions, LogTimestampFormat timestampFormat, bool sourceLocation,
+                  LogFileFormat format = LogFileFormat::Text);
+
+   /**
+    * @brief appendMessage Renders the line of a record in UTF-8 at the end of a buffer, following the layout. No
+    * intermediate string is built. The fields of the record follow the message.
+    * @param record The record to format.
+    * @param out The buffer where the line, ended by a new line, is appended.
+    */
+   void appendMessage(const LogRecord &record, QByteArray &out);
+
+   /**
+    * @brief formatMessage Builds the line of text of a record following the layout.
+    * @param record The record to format.
+    * @return The line to log, ended by a new line.
+    */
+   QString formatMessage(const LogRecord &record);
+
+   /**
+    * @brief appendUtf8 Encodes a text in UTF-8 at the end of a buffer.
+    * @param text The text to encode.
+    * @param out The buffer where the text is appended.
+    */
+   static void appendUtf8(const QString &text, QByteArray &out);
+
+private:
+   /**
+    * @brief The Field enum class defines the elements of a line, in the order they are written.
+    */
+   enum class Field
+   {
+      LogLevel,
+      ModuleName,
+      DateTime,
+      ThreadId,
+      Source,
+      Message
+   };
+
+   /**
+    * @brief The Source enum class defines which part of the source location is written for a record.
+    */
+   enum class Source
+   {
+      None,
+      Line,
+      Function
+   };
+
+   qint64 mClockOffset = 0;
+   qint64 mCachedSecond = -1;
+   QByteArray mCachedSecondText;
+   QByteArray mLine;
+
+   bool mHasLayout = false;
+   LogMessageDisplays mMessageOptions;
+   LogTimestampFormat mTimestampFormat = LogTimestampFormat::EpochSeconds;
+   bool mSourceLocation = false;
+   LogFileFormat mFormat = LogFileFormat::Text;
+   QVector<Field> mFields;
+   bool mSourceLine = false;
+   bool mSourceFunction = false;
+
+   /**
+    * @brief appendTimestamp Converts the time of a record to wall time with the timestamp format.
+    * @param timestamp The time of the record in nanoseconds.
+    * @param out The buffer where the text is appended.
+    */
+   void appendTimestamp(qint64 timestamp, QByteArray &out);
+
+   /**
+    * @brief appendSource Writes the file and the line, or the file and the function, if they are known.
+    * @param record The record to format.
+    * @param out The buffer where the text is appended.
+    */
+   void appendSource(const LogRecord &record, QByteArray &out) const;
+
+   /**
+    * @brief sourceOf Gets which part of the source location of a record is written.
+    */
+   Source sourceOf(const LogRecord &record) const;
+
+   /**
+    * @brief appendText Renders a record with the bracketed text layout. The fields are added as key=value pairs.
+    */
+   void appendText(const LogRecord &record, QByteArray &out);
+
+   /**
+    * @brief appendLogfmt Renders a record as a line of key=value pairs.
+    */
+   void appendLogfmt(const LogRecord &record, QByteArray &out);
+
+   /**
+    * @brief appendJson Renders a record as a JSON object in one line.
+    */
+   void appendJson(const LogRecord &record, QByteArray &out);
+};
+
+}
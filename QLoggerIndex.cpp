@@ -0,0 +1,152 @@
+#include "QLoggerIndex.h"
+
+#include <QDataStream>
+#include <QFile>
+
+namespace
+{
+/**
+ * @brief Size of an entry in the index file.
+ */
+constexpr qint64 EntrySize = 4 * 8 + 1;
+
+void writeEntry(QDataStream &stream, const QLogger::QLoggerIndexEntry &entry)
+{
+   stream << entry.offset << entry.size << entry.firstTime << entry.lastTime << entry.levels;
+}
+}
+
+namespace QLogger
+{
+
+bool QLoggerIndex::load(const QString &logFile, QVector<QLoggerIndexEntry> &entries)
+{
+   entries.clear();
+
+   QFile file(indexPath(logFile));
+
+   if (!file.open(QIODevice::ReadOnly))
+      return false;
+
+   QDataStream stream(&file);
+   stream.setVersion(QDataStream::Qt_5_0);
+
+   quint32 magic = 0;
+   quint8 version = 0;
+
+   stream >> magic >> version;
+
+   if (stream.status() != QDataStream::Ok || magic != Magic || version != Version)
+      return false;
+
+   entries.reserve(static_cast<int>((file.size() - file.pos()) / EntrySize));
+
+   while (file.size() - file.pos() >= EntrySize)
+   {
+      QLoggerIndexEntry entry;
+
+      stream >> entry.offset >> entry.size >> entry.firstTime >> entry.lastTime >> entry.levels;
+
+      if (stream.status() != QDataStream::Ok || entry.offset < 0 || entry.size < 0)
+         return false;
+
+      entries.append(entry);
+   }
+
+   return true;
+}
+
+void QLoggerIndexWriter::setInterval(qint64 interval)
+{
+   if (interval == mInterval)
+      return;
+
+   close();
+
+   mInterval = qMax<qint64>(0, interval);
+}
+
+void QLoggerIndexWriter::open(const QString &logFile, qint64 fileSize)
+{
+   if (mInterval <= 0 || (mIsOpen && logFile == mLogFile))
+      return;
+
+   close();
+
+   mLogFile = logFile;
+   mIsOpen = true;
+
+   QVector<QLoggerIndexEntry> entries;
+   const auto isValid = QLoggerIndex::load(logFile, entries);
+
+   // An index describing more data than the file has belongs to a file that has been replaced
+   if (!isValid || (!entries.isEmpty() && entries.constLast().offset + entries.constLast().size > fileSize))
+      QFile::remove(QLoggerIndex::indexPath(logFile));
+}
+
+void QLoggerIndexWriter::add(qint64 offset, qint64 size, qint64 time, LogLevel level)
+{
+   if (!mIsOpen)
+      return;
+
+   if (mHasCurrent && offset >= mCurrent.offset + mInterval)
+   {
+      mPending.append(mCurrent);
+      mHasCurrent = false;
+   }
+
+   if (!mHasCurrent)
+   {
+      mCurrent = QLoggerIndexEntry();
+      mCurrent.offset = offset;
+      mCurrent.firstTime = time;
+      mCurrent.lastTime = time;
+      mHasCurrent = true;
+   }
+
+   mCurrent.size = offset + size - mCurrent.offset;
+   mCurrent.firstTime = qMin(mCurrent.firstTime, time);
+   mCurrent.lastTime = qMax(mCurrent.lastTime, time);
+   mCurrent.levels |= static_cast<quint8>(1 << static_cast<int>(level));
+}
+
+void QLoggerIndexWriter::flush()
+{
+   if (mPending.isEmpty())
+      return;
+
+   QFile file(QLoggerIndex::indexPath(mLogFile));
+
+   if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+   {
+      QDataStream stream(&file);
+      stream.setVersion(QDataStream::Qt_5_0);
+
+      if (file.size() == 0)
+         stream << QLoggerIndex::Magic << QLoggerIndex::Version;
+
+      for (const auto &entry : std::as_const(mPending))
+         writeEntry(stream, entry);
+   }
+
+   mPending.clear();
+}
+
+void QLoggerIndexWriter::close()
+{
+   if (!mIsOpen)
+      return;
+
+   if (mHasCurrent)
+   {
+      mPending.append(mCurrent);
+      mHasCurrent = false;
+   }
+
+   flush();
+
+   mIsOpen = false;
+   mLogFile.clear();
+}
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerLevel.h>
+
+#include <QString>
+#include <QVector>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerIndexEntry struct describes a block of lines of a log file in its index.
+ */
+struct QLoggerIndexEntry
+{
+   qint64 offset = 0;
+   qint64 size = 0;
+   /**
+    * @brief Times of the first and the last message of the block, in milliseconds since epoch.
+    */
+   qint64 firstTime = 0;
+   qint64 lastTime = 0;
+   /**
+    * @brief The levels of the messages of the block, one bit per LogLevel.
+    */
+   quint8 levels = 0;
+
+   /**
+    * @brief hasLevelAtLeast Checks if the block has a message of the given level or above.
+    */
+   bool hasLevelAtLeast(LogLevel level) const { return (levels >> static_cast<int>(level)) != 0; }
+};
+
+namespace QLoggerIndex
+{
+/**
+ * @brief Header of the index file, before the entries.
+ */
+constexpr quint32 Magic = 0x514C4958; // "QLIX"
+constexpr quint8 Version = 1;
+
+/**
+ * @brief indexPath Gets the path of the index written alongside a log file.
+ */
+inline QString indexPath(const QString &logFile)
+{
+   return logFile + QStringLiteral(".idx");
+}
+
+/**
+ * @brief load Reads the index of a log file. An entry cut by a crash of the writer is ignored.
+ * @param logFile The log file.
+ * @param entries The entries of the index, in the order of the file.
+ * @return True if the index exists and is valid, otherwise false.
+ */
+bool load(const QString &logFile, QVector<QLoggerIndexEntry> &entries);
+}
+
+/**
+ * @brief The QLoggerIndexWriter class builds the sparse index of a text log file while it is written: one entry every
+ * interval of bytes with the times and the levels of its messages. The entries are appended to the index file when
+ * the data of the log file is written, and the index follows the log file when it is rotated.
+ */
+class QLoggerIndexWriter
+{
+public:
+   /**
+    * @brief interval Gets the minimum size of the blocks of the index, zero when the file is not indexed.
+    */
+   qint64 interval() const { return mInterval; }
+
+   /**
+    * @brief setInterval Sets the minimum size of the blocks of the index. Zero stops indexing.
+    * @param interval The size in bytes.
+    */
+   void setInterval(qint64 interval);
+
+   /**
+    * @brief isOpen Checks if a log file is being indexed.
+    */
+   bool isOpen() const { return mIsOpen; }
+
+   /**
+    * @brief open Starts indexing a log file, or keeps going if it is already the indexed one. An existing index is
+    * continued, unless the log file is smaller than what it describes.
+    * @param logFile The log file.
+    * @param fileSize The current size of the log file.
+    */
+   void open(const QString &logFile, qint64 fileSize);
+
+   /**
+    * @brief add Adds a message to the index.
+    * @param offset The position of the line in the log file.
+    * @param size The size of the line.
+    * @param time The time of the message in milliseconds since epoch.
+    * @param level The level of the message.
+    */
+   void add(qint64 offset, qint64 size, qint64 time, LogLevel level);
+
+   /**
+    * @brief flush Appends the completed entries to the index file.
+    */
+   void flush();
+
+   /**
+    * @brief close Completes the current entry, appends it to the index file and stops indexing the log file.
+    */
+   void close();
+
+private:
+   qint64 mInterval = 0;
+   bool mIsOpen = false;
+   QString mLogFile;
+   QLoggerIndexEntry mCurrent;
+   bool mHasCurrent = false;
+   QVector<QLoggerIndexEntry> mPending;
+};
+
+}
@@ -51,7 +51,12 @@ enum class LogMode
    Disabled = 0,
    OnlyConsole,
    OnlyFile,
-   Full
+   Full,
+   /**
+    * @brief The messages are only kept in a fixed amount of memory, and written to the file when they are dumped: on
+    * demand, on a Fatal message or on a crash.
+    */
+   Memory
 };
 
 /**
@@ -63,6 +68,148 @@ enum class LogFileDisplay
    Number
 };
 
+/**
+ * @brief The LogFileAccess enum class defines how the log file is accessed by the writer.
+ */
+enum class LogFileAccess
+{
+   /**
+    * @brief The file is opened and closed for every batch of messages.
+    */
+   OpenPerBatch,
+   /**
+    * @brief The file is kept open and the writes are buffered following the flush policy.
+    */
+   Persistent,
+   /**
+    * @brief The file is preallocated to the maximum file size and mapped in memory. Every batch is copied into the
+    * mapping, so it survives a crash of the process in the page cache. The file is truncated to the real size when
+    * it is rotated or closed. Meanwhile, a ".end" file next to it keeps the size of the data, for the readers and for
+    * the next run after a crash.
+    */
+   MemoryMapped
+};
+
+/**
+ * @brief The LogCompression enum class defines how the rotated log files are compressed.
+ */
+enum class LogCompression
+{
+   None,
+   /**
+    * @brief The rotated file is replaced by a .gz file in the background.
+    */
+   Gzip
+};
+
+/**
+ * @brief The LogQueuePolicy enum class defines what happens when a message is logged and the queue of the writer is
+ * full.
+ */
+enum class LogQueuePolicy
+{
+   /**
+    * @brief The logging thread waits until the writer has room for the message.
+    */
+   Block,
+   /**
+    * @brief The new message is dropped.
+    */
+   DropNewest,
+   /**
+    * @brief The oldest message in the queue is dropped to make room for the new one.
+    */
+   DropOldest,
+   /**
+    * @brief The new message is dropped if its level is lower than the drop level.
+    */
+   DropBelowLevel
+};
+
+/**
+ * @brief The LogFsyncPolicy enum class defines when the data written in the log file is synchronized to the disk.
+ */
+enum class LogFsyncPolicy
+{
+   /**
+    * @brief The system decides when the data reaches the disk.
+    */
+   Never,
+   /**
+    * @brief Every batch is written and synchronized.
+    */
+   PerBatch,
+   /**
+    * @brief The batches with Error or Fatal messages are written and synchronized.
+    */
+   OnError,
+   /**
+    * @brief The data is synchronized at most once per interval.
+    */
+   Interval
+};
+
+/**
+ * @brief The LogTimestampFormat enum class defines how the date and time of a log message is written.
+ */
+enum class LogTimestampFormat
+{
+   EpochSeconds,
+   EpochMillis,
+   EpochMicros,
+   /**
+    * @brief UTC date and time with milliseconds, for instance 2022-01-31T18:30:00.123Z
+    */
+   Iso8601Millis
+};
+
+/**
+ * @brief The LogFileFormat enum class defines how the messages are stored in the log file. The JSON lines and logfmt
+ * formats apply to the console as well.
+ */
+enum class LogFileFormat
+{
+   Text,
+   /**
+    * @brief Compact records with the repeated strings interned, converted back to text with QLoggerDecoder. The file
+    * is always kept open, as with LogFileAccess::Persistent.
+    */
+   Binary,
+   /**
+    * @brief One JSON object per line, with the elements of the message options and the fields of the message.
+    */
+   JsonLines,
+   /**
+    * @brief One line of key=value pairs per message, with the elements of the message options and the fields of the
+    * message.
+    */
+   Logfmt
+};
+
+/**
+ * @brief The LogConsoleOption enum class defines how the messages are written in the console. Without options, the
+ * messages are written to stdout.
+ */
+enum class LogConsoleOption : unsigned int
+{
+   /**
+    * @brief The messages of level Error and Fatal are written to stderr.
+    */
+   ErrorsToStderr = 1 << 0,
+   /**
+    * @brief Every line is colored with ANSI escape sequences depending on its level.
+    */
+   Colors = 1 << 1,
+   /**
+    * @brief The messages go through qInfo() one by one, so they reach the Qt message handler as before. The other
+    * options are ignored.
+    */
+   MessageHandler = 1 << 2
+};
+
+Q_DECLARE_FLAGS(LogConsoleOptions, LogConsoleOption)
+Q_DECLARE_OPERATORS_FOR_FLAGS(LogConsoleOptions)
+
 /**
  * @brief The LogTextDisplay enum class defines which elements are written by log message.
  */
@@ -0,0 +1,135 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <atomic>
+#include <utility>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerQueue class is an unbounded multi-producer single-consumer queue. Producers
+ * never block each other: every push is a single atomic exchange. Only one thread at a time is
+ * allowed to pop.
+ */
+template<typename T>
+class QLoggerQueue
+{
+public:
+   QLoggerQueue()
+      : mHead(&mStub)
+      , mTail(&mStub)
+   {
+   }
+
+   ~QLoggerQueue()
+   {
+      T value;
+
+      while (pop(value))
+         ;
+   }
+
+   QLoggerQueue(const QLoggerQueue &) = delete;
+   QLoggerQueue &operator=(const QLoggerQueue &) = delete;
+
+   /**
+    * @brief push Appends a value at the end of the queue. Safe to call from any thread.
+    * @param value The value to enqueue.
+    */
+   void push(T &&value) { pushNode(new Node(std::move(value))); }
+
+   /**
+    * @brief pop Takes the value at the front of the queue. Must only be called from the consumer.
+    *
+    * @param value The value that has been dequeued.
+    * @return False if the queue is empty or if a producer is still linking the next value.
+    */
+   bool pop(T &value)
+   {
+      auto tail = mTail;
+      auto next = tail->next.load(std::memory_order_acquire);
+
+      if (tail == &mStub)
+      {
+         if (!next)
+            return false;
+
+         mTail = next;
+         tail = next;
+         next = next->next.load(std::memory_order_acquire);
+      }
+
+      if (next)
+      {
+         mTail = next;
+         value = std::move(tail->value);
+         delete tail;
+         return true;
+      }
+
+      if (tail != mHead.load(std::memory_order_acquire))
+         return false;
+
+      pushNode(&mStub);
+
+      next = tail->next.load(std::memory_order_acquire);
+
+      if (next)
+      {
+         mTail = next;
+         value = std::move(tail->value);
+         delete tail;
+         return true;
+      }
+
+      return false;
+   }
+
+private:
+   struct Node
+   {
+      Node() = default;
+      explicit Node(T &&v)
+         : value(std::move(v))
+      {
+      }
+
+      std::atomic<Node *> next { nullptr };
+      T value;
+   };
+
+   void pushNode(Node *node)
+   {
+      node->next.store(nullptr, std::memory_order_relaxed);
+      const auto prev = mHead.exchange(node, std::memory_order_acq_rel);
+      prev->next.store(node, std::memory_order_release);
+   }
+
+   Node mStub;
+   std::atomic<Node *> mHead;
+   Node *mTail;
+};
+
+}
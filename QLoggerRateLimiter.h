@@ -0,0 +1,109 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QtGlobal>
+
+#include <atomic>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerRateLimiter class limits the messages of one call site of the QLog_* macros. It is a generic cell
+ * rate algorithm: a token bucket kept in a single timestamp, so a check is one load and one compare-and-swap, without
+ * any lock. It has a constexpr constructor, so the static instances of the macros need no guard.
+ */
+class QLoggerRateLimiter
+{
+public:
+   constexpr QLoggerRateLimiter() = default;
+
+   QLoggerRateLimiter(const QLoggerRateLimiter &) = delete;
+   QLoggerRateLimiter &operator=(const QLoggerRateLimiter &) = delete;
+
+   /**
+    * @brief tryAcquire Takes one token of the bucket if there is any.
+    * @param now The current time of the monotonic clock in nanoseconds.
+    * @param interval The time in nanoseconds between two messages in the long run.
+    * @param burst The amount of messages that can be logged at once.
+    * @param suppressed Set to the amount of messages refused since the last accepted one, when the message is
+    * accepted.
+    * @return True if the message can be logged, otherwise false.
+    */
+   bool tryAcquire(qint64 now, qint64 interval, int burst, quint64 &suppressed)
+   {
+      // The bucket is full once the theoretical arrival time is in the past
+      const auto tolerance = interval * (qMax(1, burst) - 1);
+      auto arrival = mArrival.load(std::memory_order_relaxed);
+
+      while (true)
+      {
+         if (arrival - now > tolerance)
+         {
+            mSuppressed.fetch_add(1, std::memory_order_seq_cst);
+            return false;
+         }
+
+         if (mArrival.compare_exchange_weak(arrival, qMax(arrival, now) + interval, std::memory_order_relaxed))
+            break;
+      }
+
+      suppressed = mSuppressed.load(std::memory_order_relaxed) > 0
+          ? mSuppressed.exchange(0, std::memory_order_relaxed)
+          : 0;
+
+      return true;
+   }
+
+   /**
+    * @brief markPending Flags the limiter as waiting for the periodic report of its suppressed messages.
+    * @return True if it was not flagged yet, so the caller has to register it for the report.
+    */
+   bool markPending()
+   {
+      return !mPending.load(std::memory_order_seq_cst) && !mPending.exchange(true, std::memory_order_seq_cst);
+   }
+
+   /**
+    * @brief takeSuppressed Clears the flag of markPending and takes the messages refused since the last report or
+    * the last accepted message. A message refused meanwhile flags the limiter again, so it is never lost.
+    * @return The amount of messages refused.
+    */
+   quint64 takeSuppressed()
+   {
+      mPending.store(false, std::memory_order_seq_cst);
+
+      return mSuppressed.exchange(0, std::memory_order_seq_cst);
+   }
+
+private:
+   /**
+    * @brief Theoretical arrival time of the next message that keeps the rate, in nanoseconds.
+    */
+   std::atomic<qint64> mArrival { 0 };
+   std::atomic<quint64> mSuppressed { 0 };
+   std::atomic<bool> mPending { false };
+};
+
+}
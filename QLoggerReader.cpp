@@ -0,0 +1,507 @@
+#include "QLoggerReader.h"
+
+#include "QLoggerDataEnd.h"
+#include "QLoggerRotation.h"
+
+#include <QFileInfo>
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+/**
+ * @brief Size of the chunks of the parts of a file that are not indexed.
+ */
+constexpr qint64 GapChunkSize = 1024 * 1024;
+
+/**
+ * @brief Bits of every level in an entry of the index.
+ */
+constexpr quint8 AllLevels = 0x3F;
+
+bool parseLevel(const char *text, qint64 size, QLogger::LogLevel &level)
+{
+   static const struct
+   {
+      const char *name;
+      QLogger::LogLevel level;
+   } levels[] = { { "Trace", QLogger::LogLevel::Trace }, { "Debug", QLogger::LogLevel::Debug },
+                  { "Info", QLogger::LogLevel::Info },   { "Warning", QLogger::LogLevel::Warning },
+                  { "Error", QLogger::LogLevel::Error }, { "Fatal", QLogger::LogLevel::Fatal } };
+
+   for (const auto &entry : levels)
+   {
+      if (static_cast<qint64>(std::strlen(entry.name)) == size && std::memcmp(text, entry.name, size) == 0)
+      {
+         level = entry.level;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/**
+ * @brief Reads a timestamp of any LogTimestampFormat as the range of milliseconds it covers.
+ */
+bool parseTime(const char *text, qint64 size, qint64 &from, qint64 &to)
+{
+   if (size <= 0)
+      return false;
+
+   auto isNumber = size <= 18;
+   qint64 value = 0;
+
+   for (auto i = 0; isNumber && i < size; ++i)
+   {
+      isNumber = text[i] >= '0' && text[i] <= '9';
+      value = value * 10 + (text[i] - '0');
+   }
+
+   // The epoch timestamps are told apart by their magnitude: seconds, milliseconds or microseconds
+   if (isNumber)
+   {
+      if (value < 100000000000LL)
+      {
+         from = value * 1000;
+         to = from + 999;
+      }
+      else
+      {
+         from = value < 100000000000000LL ? value : value / 1000;
+         to = from;
+      }
+
+      return true;
+   }
+
+   if (size < 19 || text[4] != '-' || text[10] != 'T')
+      return false;
+
+   const auto time = QDateTime::fromString(QString::fromLatin1(text, static_cast<int>(size)), Qt::ISODateWithMs);
+
+   if (!time.isValid())
+      return false;
+
+   from = time.toMSecsSinceEpoch();
+   to = from;
+
+   return true;
+}
+
+/**
+ * @brief Finds the value of a key of a Json or a Logfmt line. The values are not unescaped.
+ * @param key The key with its separator, as "level=".
+ * @param quoted If true the value ends at the next quote, otherwise at the next separator.
+ */
+bool findValue(const char *data, qint64 size, const char *key, bool quoted, const char *&value, qint64 &valueSize)
+{
+   const auto keySize = static_cast<qint64>(std::strlen(key));
+   const auto line = QByteArray::fromRawData(data, static_cast<int>(size));
+   auto position = line.indexOf(key);
+
+   // A Logfmt key starts the line or follows a space, so its name is not the end of another one
+   while (!quoted && position > 0 && data[position - 1] != ' ')
+      position = line.indexOf(key, position + 1);
+
+   if (position < 0)
+      return false;
+
+   auto end = position + keySize;
+
+   while (end < size && (quoted ? data[end] != '"' : (data[end] != ' ' && data[end] != ',' && data[end] != '}')))
+      ++end;
+
+   value = data + position + keySize;
+   valueSize = end - position - keySize;
+
+   return true;
+}
+
+/**
+ * @brief The level and the time found in a line.
+ */
+struct LineInfo
+{
+   bool hasLevel = false;
+   QLogger::LogLevel level = QLogger::LogLevel::Trace;
+   bool hasTime = false;
+   qint64 from = 0;
+   qint64 to = 0;
+};
+
+LineInfo parseLine(const char *data, qint64 size)
+{
+   LineInfo info;
+   const char *value = nullptr;
+   qint64 valueSize = 0;
+
+   if (size > 0 && data[0] == '[')
+   {
+      // Text: the level and the time are among the bracketed fields that start the line
+      qint64 position = 0;
+
+      while (position < size && data[position] == '[')
+      {
+         const auto close = static_cast<const char *>(std::memchr(data + position, ']', size - position));
+
+         if (!close)
+            break;
+
+         const auto fieldSize = close - data - position - 1;
+
+         if (!info.hasLevel)
+            info.hasLevel = parseLevel(data + position + 1, fieldSize, info.level);
+
+         if (!info.hasTime)
+            info.hasTime = parseTime(data + position + 1, fieldSize, info.from, info.to);
+
+         position = close - data + 1;
+      }
+   }
+   else if (size > 0 && data[0] == '{')
+   {
+      if (findValue(data, size, "\"level\":\"", true, value, valueSize))
+         info.hasLevel = parseLevel(value, valueSize, info.level);
+
+      if (findValue(data, size, "\"time\":", false, value, valueSize))
+      {
+         if (valueSize >= 2 && value[0] == '"')
+            info.hasTime = parseTime(value + 1, valueSize - 2, info.from, info.to);
+         else
+            info.hasTime = parseTime(value, valueSize, info.from, info.to);
+      }
+   }
+   else
+   {
+      if (findValue(data, size, "level=", false, value, valueSize))
+         info.hasLevel = parseLevel(value, valueSize, info.level);
+
+      if (findValue(data, size, "time=", false, value, valueSize))
+         info.hasTime = parseTime(value, valueSize, info.from, info.to);
+   }
+
+   return info;
+}
+}
+
+namespace QLogger
+{
+
+QLoggerReader::QLoggerReader(const QString &fileDestination)
+   : mFileDestination(fileDestination)
+   , mFrom(std::numeric_limits<qint64>::min())
+   , mTo(std::numeric_limits<qint64>::max())
+{
+}
+
+void QLoggerReader::setTimeRange(qint64 from, qint64 to)
+{
+   mFrom = from;
+   mTo = to;
+
+   rewind();
+}
+
+void QLoggerReader::setTimeRange(const QDateTime &from, const QDateTime &to)
+{
+   setTimeRange(from.isValid() ? from.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min(),
+                to.isValid() ? to.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max());
+}
+
+void QLoggerReader::setLevel(LogLevel level)
+{
+   mLevel = level;
+
+   rewind();
+}
+
+void QLoggerReader::rewind()
+{
+   closeFile();
+
+   mStarted = false;
+   mSkip = 0;
+}
+
+void QLoggerReader::start()
+{
+   mFiles = QLoggerRotation::rotatedFiles(mFileDestination);
+
+   if (QFileInfo::exists(mFileDestination))
+      mFiles.append(mFileDestination);
+
+   mFileIndex = -1;
+   mStarted = true;
+}
+
+void QLoggerReader::tail(int count)
+{
+   rewind();
+   start();
+
+   for (auto file = mFiles.size() - 1; count > 0 && file >= 0; --file)
+   {
+      if (!openFile(static_cast<int>(file)))
+         continue;
+
+      // The blocks are counted from the end until they hold enough lines, the reading starts in the last one counted
+      for (auto segment = mSegments.size() - 1; segment >= 0; --segment)
+      {
+         if (!accepts(mSegments.at(segment)))
+            continue;
+
+         enterSegment(static_cast<int>(segment));
+
+         const char *data = nullptr;
+         qint64 size = 0;
+         auto matches = 0;
+
+         while (readLine(data, size))
+            ++matches;
+
+         if (matches >= count)
+         {
+            enterSegment(static_cast<int>(segment));
+            mSkip = matches - count;
+            return;
+         }
+
+         count -= matches;
+      }
+   }
+
+   rewind();
+
+   // Without lines to read nothing is left, otherwise there are fewer lines than asked for and all of them are read
+   if (count <= 0)
+   {
+      start();
+      mFileIndex = static_cast<int>(mFiles.size());
+   }
+}
+
+bool QLoggerReader::next(QByteArray &line)
+{
+   if (!mStarted)
+      start();
+
+   const char *data = nullptr;
+   qint64 size = 0;
+
+   do
+   {
+      while (readLine(data, size))
+      {
+         if (mSkip > 0)
+         {
+            --mSkip;
+            continue;
+         }
+
+         line = QByteArray::fromRawData(data, static_cast<int>(size));
+         return true;
+      }
+   } while (advance());
+
+   line.clear();
+
+   return false;
+}
+
+bool QLoggerReader::openFile(int index)
+{
+   closeFile();
+
+   mFileIndex = index;
+   mFile.setFileName(mFiles.at(index));
+
+   const QFileInfo info(mFile.fileName());
+
+   // The lines of a rotated file are older than its last change. The current file may be mapped by the writer, which
+   // does not always update the time.
+   if (index + 1 < mFiles.size() && mFrom != std::numeric_limits<qint64>::min()
+       && info.lastModified().toMSecsSinceEpoch() < mFrom)
+   {
+      return false;
+   }
+
+   if (!mFile.open(QIODevice::ReadOnly))
+      return false;
+
+   mSize = mFile.size();
+   mData = mSize > 0 ? mFile.map(0, mSize) : nullptr;
+
+   if (!mData)
+   {
+      closeFile();
+      return false;
+   }
+
+   // A memory-mapped log file is preallocated after its data, its marker tells where the data ends
+   qint64 dataEnd = 0;
+
+   if (QLoggerDataEnd::read(mFile.fileName(), dataEnd))
+      mSize = qMin(mSize, dataEnd);
+
+   QVector<QLoggerIndexEntry> entries;
+   QLoggerIndex::load(mFile.fileName(), entries);
+
+   qint64 position = 0;
+
+   for (const auto &entry : std::as_const(entries))
+   {
+      // The rest of an index that does not match the file anymore is not used
+      if (entry.offset < position || entry.offset + entry.size > mSize)
+         break;
+
+      addGap(position, entry.offset);
+      mSegments.append(entry);
+      position = entry.offset + entry.size;
+   }
+
+   addGap(position, mSize);
+
+   return true;
+}
+
+void QLoggerReader::closeFile()
+{
+   if (mData)
+      mFile.unmap(mData);
+
+   mFile.close();
+
+   mData = nullptr;
+   mSize = 0;
+   mSegments.clear();
+   mSegmentIndex = -1;
+   mPosition = 0;
+   mSegmentEnd = 0;
+}
+
+void QLoggerReader::addGap(qint64 from, qint64 to)
+{
+   while (from < to)
+   {
+      auto end = qMin(to, from + GapChunkSize);
+
+      if (end < to)
+      {
+         const auto newline = static_cast<const uchar *>(std::memchr(mData + end, '\n', to - end));
+
+         end = newline ? newline - mData + 1 : to;
+      }
+
+      QLoggerIndexEntry gap;
+      gap.offset = from;
+      gap.size = end - from;
+      gap.firstTime = std::numeric_limits<qint64>::min();
+      gap.lastTime = std::numeric_limits<qint64>::max();
+      gap.levels = AllLevels;
+
+      mSegments.append(gap);
+      from = end;
+   }
+}
+
+bool QLoggerReader::accepts(const QLoggerIndexEntry &segment) const
+{
+   return segment.hasLevelAtLeast(mLevel) && segment.lastTime >= mFrom && segment.firstTime <= mTo;
+}
+
+void QLoggerReader::enterSegment(int index)
+{
+   const auto &segment = mSegments.at(index);
+
+   mSegmentIndex = index;
+   mPosition = segment.offset;
+   mSegmentEnd = segment.offset + segment.size;
+   mHasLineLevel = false;
+   mHasLineTime = false;
+
+   // A block that does not start a line is read from the next one
+   if (mPosition > 0 && mData[mPosition - 1] != '\n')
+   {
+      const auto newline = static_cast<const uchar *>(std::memchr(mData + mPosition, '\n', mSize - mPosition));
+
+      mPosition = newline ? newline - mData + 1 : mSize;
+   }
+}
+
+bool QLoggerReader::advance()
+{
+   while (true)
+   {
+      while (mData && ++mSegmentIndex < mSegments.size())
+      {
+         if (accepts(mSegments.at(mSegmentIndex)))
+         {
+            enterSegment(mSegmentIndex);
+            return true;
+         }
+      }
+
+      if (mFileIndex + 1 >= mFiles.size())
+      {
+         closeFile();
+         mFileIndex = static_cast<int>(mFiles.size());
+         return false;
+      }
+
+      openFile(mFileIndex + 1);
+   }
+}
+
+bool QLoggerReader::readLine(const char *&data, qint64 &size)
+{
+   while (mPosition < mSegmentEnd)
+   {
+      const auto start = reinterpret_cast<const char *>(mData) + mPosition;
+      const auto newline = static_cast<const char *>(std::memchr(start, '\n', mSize - mPosition));
+
+      // The last line is still being written
+      if (!newline)
+      {
+         mPosition = mSegmentEnd;
+         return false;
+      }
+
+      size = newline - start;
+      mPosition += size + 1;
+
+      if (matches(start, size))
+      {
+         data = start;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+bool QLoggerReader::matches(const char *data, qint64 size)
+{
+   const auto info = parseLine(data, size);
+
+   if (info.hasLevel)
+   {
+      mHasLineLevel = true;
+      mLineLevel = info.level;
+   }
+
+   if (info.hasTime)
+   {
+      mHasLineTime = true;
+      mLineFrom = info.from;
+      mLineTo = info.to;
+   }
+
+   const auto levelMatches = mHasLineLevel ? mLineLevel >= mLevel : mLevel == LogLevel::Trace;
+   const auto timeMatches = !mHasLineTime || (mLineTo >= mFrom && mLineFrom <= mTo);
+
+   return levelMatches && timeMatches;
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerIndex.h>
+#include <QLoggerLevel.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerReader class reads the text log files of a destination, the rotated ones first and the current
+ * one last, filtered by time and level. The files are memory-mapped read-only one at a time, so the reader does not
+ * take any lock or handle of the writer and can run while it logs.
+ *
+ * When the writer indexes the files (see QLoggerManager::setDefaultIndexInterval), the blocks out of the query are
+ * skipped without reading them. Otherwise the lines are read in chunks, so a tail still only reads the end of the
+ * files. The level and the time of each line are taken from the line itself, in the Text, Logfmt and Json formats;
+ * a line without them takes the ones of the line before, and a line without any is only kept when the reader
+ * accepts every level. A line being written, without its end of line yet, is left out.
+ */
+class QLoggerReader
+{
+public:
+   /**
+    * @brief QLoggerReader Constructor of the reader of a destination.
+    * @param fileDestination The complete path of the log file.
+    */
+   explicit QLoggerReader(const QString &fileDestination);
+
+   /**
+    * @brief setTimeRange Reads only the lines logged between two times, both included. It starts the reading again.
+    * @param from The first time in milliseconds since epoch.
+    * @param to The last time in milliseconds since epoch.
+    */
+   void setTimeRange(qint64 from, qint64 to);
+
+   /**
+    * @brief setTimeRange Reads only the lines logged between two times, both included. An invalid time leaves that
+    * side of the range open. It starts the reading again.
+    * @param from The first time.
+    * @param to The last time.
+    */
+   void setTimeRange(const QDateTime &from, const QDateTime &to);
+
+   /**
+    * @brief setLevel Reads only the lines of a level or above. It starts the reading again.
+    * @param level The minimum level.
+    */
+   void setLevel(LogLevel level);
+
+   /**
+    * @brief rewind Starts the reading again from the oldest file.
+    */
+   void rewind();
+
+   /**
+    * @brief tail Moves the reading to the last lines that match the query, the oldest of them first.
+    * @param count The amount of lines.
+    */
+   void tail(int count);
+
+   /**
+    * @brief next Reads the next line that matches the query.
+    * @param line Set to the line, without the end of line. It points into the mapped file and is only valid until
+    * the next call.
+    * @return True if a line has been read, false at the end of the files.
+    */
+   bool next(QByteArray &line);
+
+private:
+   QString mFileDestination;
+   qint64 mFrom;
+   qint64 mTo;
+   LogLevel mLevel = LogLevel::Trace;
+   bool mStarted = false;
+   QStringList mFiles;
+   int mFileIndex = -1;
+   QFile mFile;
+   uchar *mData = nullptr;
+   qint64 mSize = 0;
+   /**
+    * @brief The blocks of the open file: the entries of its index, and the parts not indexed split in chunks with
+    * every level and no time bound.
+    */
+   QVector<QLoggerIndexEntry> mSegments;
+   int mSegmentIndex = -1;
+   qint64 mPosition = 0;
+   qint64 mSegmentEnd = 0;
+   /**
+    * @brief The last level and time read, for the lines that do not have them.
+    */
+   bool mHasLineLevel = false;
+   LogLevel mLineLevel = LogLevel::Trace;
+   bool mHasLineTime = false;
+   qint64 mLineFrom = 0;
+   qint64 mLineTo = 0;
+   /**
+    * @brief Matching lines to skip before returning one, when a tail starts in the middle of a block.
+    */
+   int mSkip = 0;
+
+   /**
+    * @brief start Lists the files of the destination and starts the reading before the first one.
+    */
+   void start();
+
+   /**
+    * @brief openFile Maps a file and splits it in blocks. A file modified before the time range has no blocks.
+    * @param index The position of the file in the list.
+    * @return True if the file has been mapped, otherwise false.
+    */
+   bool openFile(int index);
+
+   /**
+    * @brief closeFile Unmaps the open file, if any.
+    */
+   void closeFile();
+
+   /**
+    * @brief addGap Adds the blocks of a part of the file that is not indexed, ending on full lines.
+    */
+   void addGap(qint64 from, qint64 to);
+
+   /**
+    * @brief accepts Checks if a block may have lines that match the query.
+    */
+   bool accepts(const QLoggerIndexEntry &segment) const;
+
+   /**
+    * @brief enterSegment Moves the reading to the first full line of a block of the open file.
+    */
+   void enterSegment(int index);
+
+   /**
+    * @brief advance Moves the reading to the next block that may match the query, in the open file or the next ones.
+    * @return True if there is one, false at the end of the files.
+    */
+   bool advance();
+
+   /**
+    * @brief readLine Reads the next line of the current block that matches the query.
+    * @param data Set to the start of the line.
+    * @param size Set to the size of the line, without the end of line.
+    * @return True if a line has been read, false at the end of the block.
+    */
+   bool readLine(const char *&data, qint64 &size);
+
+   /**
+    * @brief matches Takes the level and the time of a line and checks them against the query.
+    */
+   bool matches(const char *data, qint64 size);
+};
+
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerLevel.h>
+
+#include <QString>
+#include <QVector>
+
+#include <chrono>
+#include <type_traits>
+#include <utility>
+
+namespace QLogger
+{
+
+/**
+ * @brief The LogField struct holds a typed key/value attached to a log message. The value is stored as it is given,
+ * and only converted to text by the QLoggerWriter thread.
+ */
+struct LogField
+{
+   enum class Type : quint8
+   {
+      Int,
+      UInt,
+      Double,
+      Bool,
+      String
+   };
+
+   LogField() = default;
+
+   /**
+    * @brief Builds a field with a string literal as key, that is kept by address. Any other const char * is copied
+    * into keyName by the QString constructor, as it may not live until the writer thread reads it.
+    */
+   template<int N, typename T>
+   LogField(const char (&key)[N], T &&value)
+      : key(key)
+   {
+      setValue(std::forward<T>(value));
+   }
+
+   /**
+    * @brief Builds a field with a key in a char buffer, that is copied since the buffer can change.
+    */
+   template<int N, typename T>
+   LogField(char (&key)[N], T &&value)
+      : keyName(QString::fromUtf8(key))
+   {
+      setValue(std::forward<T>(value));
+   }
+
+   template<typename T>
+   LogField(const QString &key, T &&value)
+      : keyName(key)
+   {
+      setValue(std::forward<T>(value));
+   }
+
+   /**
+    * @brief Static literal of the key. When it is null keyName is used instead.
+    */
+   const char *key = nullptr;
+   QString keyName;
+   Type type = Type::Int;
+   union
+   {
+      qint64 intValue = 0;
+      quint64 uintValue;
+      double doubleValue;
+      bool boolValue;
+   };
+   /**
+    * @brief The value of the fields of type String.
+    */
+   QString text;
+
+private:
+   void setValue(bool value)
+   {
+      type = Type::Bool;
+      boolValue = value;
+   }
+
+   void setValue(double value)
+   {
+      type = Type::Double;
+      doubleValue = value;
+   }
+
+   template<typename T>
+   typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type setValue(T value)
+   {
+      type = Type::Int;
+      intValue = static_cast<qint64>(value);
+   }
+
+   template<typename T>
+   typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value
+                           && !std::is_same<T, bool>::value>::type
+   setValue(T value)
+   {
+      type = Type::UInt;
+      uintValue = static_cast<quint64>(value);
+   }
+
+   void setValue(const QString &value)
+   {
+      type = Type::String;
+      text = value;
+   }
+
+   void setValue(QString &&value)
+   {
+      type = Type::String;
+      text = std::move(value);
+   }
+
+   void setValue(const char *value)
+   {
+      type = Type::String;
+      text = QString::fromUtf8(value);
+   }
+};
+
+/**
+ * @brief sourceFileName Gets the name of a source file without its folders. The QLog_* macros evaluate it at compile
+ * time on __FILE__, so the path is never stripped while logging.
+ * @param path The path of the file.
+ * @return A pointer to the file name inside the same string.
+ */
+constexpr const char *sourceFileName(const char *path)
+{
+   auto name = path;
+
+   for (auto c = path; *c != '\0'; ++c)
+   {
+      if (*c == '/' || *c == '\\')
+         name = c + 1;
+   }
+
+   return name;
+}
+
+/**
+ * @brief The LogRecord struct holds the raw data of one log message. It is built by the logging thread and only
+ * formatted later on by the QLoggerWriter thread.
+ */
+struct LogRecord
+{
+   /**
+    * @brief Gets the current time of the monotonic clock used for the timestamps.
+    * @return The time in nanoseconds.
+    */
+   static qint64 currentTimestamp()
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+   }
+
+   /**
+    * @brief Time of the monotonic clock, in nanoseconds, when the message was logged. It is converted to wall time
+    * by the writer.
+    */
+   qint64 timestamp = 0;
+   /**
+    * @brief Identifier of the thread that logged the message, as it is displayed. It is shared with the cache of
+    * the thread, so copying it does not allocate.
+    */
+   QString threadId;
+   LogLevel level = LogLevel::Info;
+   int line = -1;
+   /**
+    * @brief Static literals (__FUNCTION__ and the file name of __FILE__) given by the QLog_* macros. When they are
+    * null the QString versions are used instead.
+    */
+   const char *function = nullptr;
+   const char *file = nullptr;
+   QString functionName;
+   QString fileName;
+   QString module;
+   QString message;
+   /**
+    * @brief Typed key/values given with the QLog_*Fields macros, empty for the plain messages.
+    */
+   QVector<LogField> fields;
+};
+
+}
@@ -0,0 +1,142 @@
+#include "QLoggerRingBuffer.h"
+
+#include <climits>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+namespace
+{
+/**
+ * @brief Writes the whole data to a file descriptor. A failure is not reported, it is only used for dumps.
+ */
+void writeAll(int fd, const char *data, qint64 size)
+{
+   while (size > 0)
+   {
+#ifdef Q_OS_WIN
+      const auto chunk = static_cast<unsigned int>(qMin<qint64>(size, INT_MAX));
+      const auto written = static_cast<qint64>(_write(fd, data, chunk));
+#else
+      const auto written = static_cast<qint64>(::write(fd, data, static_cast<size_t>(size)));
+#endif
+
+      if (written <= 0)
+         return;
+
+      data += written;
+      size -= written;
+   }
+}
+}
+
+namespace QLogger
+{
+
+void QLoggerRingBuffer::setCapacity(int capacity)
+{
+   clear();
+
+   mData = QByteArray(qMax(0, capacity), '\0');
+}
+
+void QLoggerRingBuffer::append(const char *data, qint64 size)
+{
+   const auto capacity = static_cast<qint64>(mData.size());
+
+   if (capacity == 0 || size <= 0)
+      return;
+
+   auto written = mWritten.load(std::memory_order_relaxed);
+
+   // Only the end of a block larger than the memory would be kept anyway
+   if (size > capacity)
+   {
+      written += size - capacity;
+      data += size - capacity;
+      size = capacity;
+   }
+
+   const auto position = written % capacity;
+   const auto firstSize = qMin(size, capacity - position);
+
+   std::memcpy(mData.data() + position, data, static_cast<size_t>(firstSize));
+   std::memcpy(mData.data(), data + firstSize, static_cast<size_t>(size - firstSize));
+
+   mWritten.store(written + size, std::memory_order_release);
+}
+
+QByteArray QLoggerRingBuffer::contents() const
+{
+   const char *first = nullptr;
+   const char *second = nullptr;
+   qint64 firstSize = 0;
+   qint64 secondSize = 0;
+
+   parts(first, firstSize, second, secondSize);
+
+   QByteArray data;
+   data.reserve(static_cast<int>(firstSize + secondSize));
+   data.append(first, static_cast<int>(firstSize));
+   data.append(second, static_cast<int>(secondSize));
+
+   return data;
+}
+
+void QLoggerRingBuffer::dump(int fd) const
+{
+   const char *first = nullptr;
+   const char *second = nullptr;
+   qint64 firstSize = 0;
+   qint64 secondSize = 0;
+
+   parts(first, firstSize, second, secondSize);
+
+   writeAll(fd, first, firstSize);
+   writeAll(fd, second, secondSize);
+}
+
+void QLoggerRingBuffer::parts(const char *&first, qint64 &firstSize, const char *&second, qint64 &secondSize) const
+{
+   const auto capacity = static_cast<qint64>(mData.size());
+   const auto written = mWritten.load(std::memory_order_acquire);
+
+   first = mData.constData();
+   second = mData.constData();
+   secondSize = 0;
+
+   if (written <= capacity)
+   {
+      firstSize = written;
+      return;
+   }
+
+   // The oldest line has been partly overwritten: the memory is given back from the end of that line
+   const auto position = written % capacity;
+
+   first = mData.constData() + position;
+   firstSize = capacity - position;
+   secondSize = position;
+
+   while (firstSize > 0)
+   {
+      --firstSize;
+
+      if (*first++ == '\n')
+         return;
+   }
+
+   while (secondSize > 0)
+   {
+      --secondSize;
+
+      if (*second++ == '\n')
+         return;
+   }
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QByteArray>
+
+#include <atomic>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerRingBuffer class keeps the last lines written in a fixed amount of memory. The oldest lines are
+ * overwritten by the new ones, and only complete lines are given back.
+ *
+ * It is written by the thread of the writer only. The dump to a file descriptor only uses async-signal-safe calls, so
+ * it can be done from a crash handler while the writer is stopped in the middle of a batch.
+ */
+class QLoggerRingBuffer
+{
+public:
+   /**
+    * @brief capacity Gets the size of the memory in bytes.
+    */
+   int capacity() const { return mData.size(); }
+
+   /**
+    * @brief setCapacity Sets the size of the memory in bytes. The lines kept so far are dropped.
+    * @param capacity The size
+    */
+   void setCapacity(int capacity);
+
+   /**
+    * @brief isEmpty Checks if there is any line kept.
+    */
+   bool isEmpty() const { return mWritten.load(std::memory_order_acquire) == 0; }
+
+   /**
+    * @brief clear Drops every line kept.
+    */
+   void clear() { mWritten.store(0, std::memory_order_release); }
+
+   /**
+    * @brief append Copies lines at the end of the memory, overwriting the oldest ones when it is full.
+    * @param data The lines, each one ended by a new line.
+    * @param size The size of the lines in bytes.
+    */
+   void append(const char *data, qint64 size);
+
+   /**
+    * @brief contents Gets the complete lines kept, the oldest first.
+    */
+   QByteArray contents() const;
+
+   /**
+    * @brief dump Writes the complete lines kept into a file descriptor, the oldest first.
+    * @param fd The file descriptor.
+    */
+   void dump(int fd) const;
+
+private:
+   QByteArray mData;
+   /**
+    * @brief Bytes appended since the memory was cleared. The next byte is written at mWritten modulo the capacity.
+    */
+   std::atomic<qint64> mWritten { 0 };
+
+   /**
+    * @brief Gets the two parts of the memory with the complete lines, the oldest part first.
+    */
+   void parts(const char *&first, qint64 &firstSize, const char *&second, qint64 &secondSize) const;
+};
+
+}
@@ -0,0 +1,285 @@
+#include "QLoggerRotation.h"
+
+#include "QLoggerIndex.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QVector>
+
+namespace
+{
+/**
+ * @brief Computes the CRC-32 of the gzip trailer.
+ */
+quint32 crc32(const QByteArray &data)
+{
+   static const auto table = [] {
+      QVector<quint32> values(256);
+
+      for (quint32 i = 0; i < 256; ++i)
+      {
+         auto value = i;
+
+         for (auto bit = 0; bit < 8; ++bit)
+            value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+
+         values[static_cast<int>(i)] = value;
+      }
+
+      return values;
+   }();
+
+   auto crc = 0xFFFFFFFFu;
+
+   for (const auto byte : data)
+      crc = table.at(static_cast<int>((crc ^ static_cast<quint8>(byte)) & 0xFF)) ^ (crc >> 8);
+
+   return crc ^ 0xFFFFFFFFu;
+}
+
+void appendLittleEndian(quint32 value, QByteArray &out)
+{
+   for (auto i = 0; i < 4; ++i)
+      out.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+/**
+ * @brief Checks if a file is a rotated file of a destination, compressed or not.
+ * @param fileName The name of the file.
+ * @param baseName The name of the log file without the extension.
+ * @param extension The extension of the log file.
+ * @return True if the file has been rotated by QLogger, otherwise false.
+ */
+bool isRotatedFile(QString fileName, const QString &baseName, const QString &extension)
+{
+   if (fileName.endsWith(QStringLiteral(".gz")))
+      fileName.chop(3);
+
+   const auto suffix = QString(".%1").arg(extension);
+
+   if (!fileName.startsWith(baseName) || !fileName.endsWith(suffix)
+       || fileName.size() <= baseName.size() + suffix.size())
+   {
+      return false;
+   }
+
+   const auto middle = fileName.mid(baseName.size(), fileName.size() - baseName.size() - suffix.size());
+
+   // Numbered with LogFileDisplay::Number, dated with LogFileDisplay::DateTime
+   if (middle.startsWith(QLatin1Char('(')) && middle.endsWith(QLatin1Char(')')))
+   {
+      auto isNumber = false;
+      middle.mid(1, middle.size() - 2).toInt(&isNumber);
+
+      return isNumber;
+   }
+
+   return middle.startsWith(QLatin1Char('_'))
+       && QDateTime::fromString(middle.mid(1), QStringLiteral("dd_MM_yy__hh_mm_ss")).isValid();
+}
+
+/**
+ * @brief The ArchiveTask class compresses a rotated file and applies the retention afterwards.
+ */
+class ArchiveTask : public QRunnable
+{
+public:
+   ArchiveTask(const QString &fileDestination, const QString &rotatedFile, QLogger::LogCompression compression,
+               int maxFiles, qint64 maxTotalSize, int maxAgeDays)
+      : mFileDestination(fileDestination)
+      , mRotatedFile(rotatedFile)
+      , mCompression(compression)
+      , mMaxFiles(maxFiles)
+      , mMaxTotalSize(maxTotalSize)
+      , mMaxAgeDays(maxAgeDays)
+   {
+   }
+
+   void run() override
+   {
+      if (mCompression == QLogger::LogCompression::Gzip
+          && QLogger::QLoggerRotation::gzipFile(mRotatedFile, QString("%1.gz").arg(mRotatedFile)))
+      {
+         QFile::remove(mRotatedFile);
+      }
+
+      QLogger::QLoggerRotation::applyRetention(mFileDestination, mMaxFiles, mMaxTotalSize, mMaxAgeDays);
+   }
+
+private:
+   QString mFileDestination;
+   QString mRotatedFile;
+   QLogger::LogCompression mCompression;
+   int mMaxFiles;
+   qint64 mMaxTotalSize;
+   int mMaxAgeDays;
+};
+}
+
+namespace QLogger
+{
+
+QLoggerRotation::QLoggerRotation()
+{
+   mPool.setMaxThreadCount(1);
+}
+
+QLoggerRotation::~QLoggerRotation()
+{
+   mPool.waitForDone();
+}
+
+void QLoggerRotation::setRetention(int maxFiles, qint64 maxTotalSize, int maxAgeDays)
+{
+   mMaxFiles = maxFiles;
+   mMaxTotalSize = maxTotalSize;
+   mMaxAgeDays = maxAgeDays;
+}
+
+QString QLoggerRotation::generateDuplicateFilename(const QString &fileDestination, const QString &fileExtension)
+{
+   if (mNextSuffixNumber == 0)
+   {
+      // The numbers start at 2, the first file being the log file itself
+      mNextSuffixNumber = 2;
+
+      const QFileInfo destination(fileDestination);
+      const auto prefix = QString("%1(").arg(destination.fileName());
+      const auto files
+          = QDir(destination.absolutePath()).entryList({ QString("%1*).%2*").arg(prefix, fileExtension) }, QDir::Files);
+
+      for (const auto &file : files)
+      {
+         auto isNumber = false;
+         const auto number = file.mid(prefix.size(), file.indexOf(QLatin1Char(')'), prefix.size()) - prefix.size())
+                                 .toInt(&isNumber);
+
+         if (isNumber && number >= mNextSuffixNumber)
+            mNextSuffixNumber = number + 1;
+      }
+   }
+
+   auto path = QString("%1(%2).%3").arg(fileDestination, QString::number(mNextSuffixNumber++), fileExtension);
+
+   // Only a file created by someone else since the scan can be in the way
+   while (QFileInfo::exists(path) || QFileInfo::exists(QString("%1.gz").arg(path)))
+      path = QString("%1(%2).%3").arg(fileDestination, QString::number(mNextSuffixNumber++), fileExtension);
+
+   return path;
+}
+
+QString QLoggerRotation::archive(const QString &fileDestination, const QString &rotatedFile)
+{
+   if (mCompression == LogCompression::None && mMaxFiles <= 0 && mMaxTotalSize <= 0 && mMaxAgeDays <= 0)
+      return rotatedFile;
+
+   mPool.start(
+       new ArchiveTask(fileDestination, rotatedFile, mCompression, mMaxFiles, mMaxTotalSize, mMaxAgeDays));
+
+   return mCompression == LogCompression::Gzip ? QString("%1.gz").arg(rotatedFile) : rotatedFile;
+}
+
+bool QLoggerRotation::gzipFile(const QString &source, const QString &destination)
+{
+   QFile input(source);
+
+   if (!input.open(QIODevice::ReadOnly))
+      return false;
+
+   const auto data = input.readAll();
+   const auto compressed = qCompress(data);
+
+   // qCompress prepends 4 bytes with the size to a zlib stream: 2 bytes of header, the deflate data and 4 bytes of
+   // Adler-32. The gzip file takes only the deflate data.
+   if (compressed.size() < 10)
+      return false;
+
+   QByteArray gzip;
+   gzip.reserve(compressed.size() + 12);
+   gzip.append("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+   gzip.append(compressed.constData() + 6, compressed.size() - 10);
+   appendLittleEndian(crc32(data), gzip);
+   appendLittleEndian(static_cast<quint32>(data.size()), gzip);
+
+   QFile output(destination);
+
+   if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      return false;
+
+   if (output.write(gzip) != gzip.size())
+   {
+      output.close();
+      QFile::remove(destination);
+
+      return false;
+   }
+
+   return true;
+}
+
+void QLoggerRotation::applyRetention(const QString &fileDestination, int maxFiles, qint64 maxTotalSize,
+                                     int maxAgeDays)
+{
+   if (maxFiles <= 0 && maxTotalSize <= 0 && maxAgeDays <= 0)
+      return;
+
+   const QFileInfo destination(fileDestination);
+   const auto baseName = destination.completeBaseName();
+   const auto extension = destination.suffix();
+   QDir dir(destination.absolutePath());
+
+   // Newest first, so the files kept are the most recent ones
+   const auto files = dir.entryInfoList({ QString("%1*").arg(baseName) }, QDir::Files | QDir::NoSymLinks, QDir::Time);
+   const auto now = QDateTime::currentDateTime();
+   auto keptFiles = 0;
+   qint64 keptSize = 0;
+   auto limitReached = false;
+
+   for (const auto &file : files)
+   {
+      if (!isRotatedFile(file.fileName(), baseName, extension))
+         continue;
+
+      const auto expired = maxAgeDays > 0 && file.lastModified().daysTo(now) >= maxAgeDays;
+      const auto tooMany = maxFiles > 0 && keptFiles >= maxFiles;
+      const auto tooLarge = maxTotalSize > 0 && keptSize + file.size() > maxTotalSize;
+
+      // Once a file is dropped every older one goes too, a smaller old file is never kept instead of a newer one
+      limitReached = limitReached || expired || tooMany || tooLarge;
+
+      if (limitReached)
+      {
+         dir.remove(file.fileName());
+         dir.remove(QLoggerIndex::indexPath(file.fileName()));
+      }
+      else
+      {
+         ++keptFiles;
+         keptSize += file.size();
+      }
+   }
+}
+
+QStringList QLoggerRotation::rotatedFiles(const QString &fileDestination)
+{
+   const QFileInfo destination(fileDestination);
+   const auto baseName = destination.completeBaseName();
+   const auto extension = destination.suffix();
+   const QDir dir(destination.absolutePath());
+   const auto files = dir.entryInfoList({ QString("%1*.%2").arg(baseName, extension) }, QDir::Files | QDir::NoSymLinks,
+                                        QDir::Time | QDir::Reversed);
+   QStringList paths;
+
+   for (const auto &file : files)
+   {
+      if (isRotatedFile(file.fileName(), baseName, extension))
+         paths.append(file.absoluteFilePath());
+   }
+
+   return paths;
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerLevel.h>
+
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+namespace QLogger
+{
+
+/**
+ * @brief The QLoggerRotation class names the rotated files of a writer and archives them. The compression and the
+ * retention run in a background thread, so the writer only pays for the rename.
+ */
+class QLoggerRotation
+{
+public:
+   QLoggerRotation();
+
+   /**
+    * @brief Destructor that waits for the files still being archived.
+    */
+   ~QLoggerRotation();
+
+   /**
+    * @brief getCompression Gets how the rotated files are compressed.
+    * @return The compression
+    */
+   LogCompression getCompression() const { return mCompression; }
+
+   /**
+    * @brief setCompression Sets how the rotated files are compressed.
+    * @param compression The compression
+    */
+   void setCompression(LogCompression compression) { mCompression = compression; }
+
+   /**
+    * @brief setRetention Sets which rotated files are kept. The newest files are kept first, and a value of zero means
+    * no limit.
+    * @param maxFiles The maximum amount of rotated files.
+    * @param maxTotalSize The maximum amount of bytes of all the rotated files.
+    * @param maxAgeDays The maximum age in days of a rotated file.
+    */
+   void setRetention(int maxFiles, qint64 maxTotalSize, int maxAgeDays);
+
+   /**
+    * @brief generateDuplicateFilename Gets the next numbered name for a rotated file. The folder is only scanned the
+    * first time, later on the number is kept in memory.
+    *
+    * @param fileDestination The file path and name without the extension.
+    * @param fileExtension The file extension
+    * @return The complete path of the duplicated file name.
+    */
+   QString generateDuplicateFilename(const QString &fileDestination, const QString &fileExtension);
+
+   /**
+    * @brief archive Compresses the rotated file and applies the retention to the rotated files of the destination,
+    * in the background.
+    * @param fileDestination The complete path of the log file.
+    * @param rotatedFile The complete path of the rotated file.
+    * @return The name the rotated file will have once archived.
+    */
+   QString archive(const QString &fileDestination, const QString &rotatedFile);
+
+   /**
+    * @brief gzipFile Writes a gzip copy of a file.
+    * @param source The file to compress.
+    * @param destination The gzip file to write.
+    * @return True if the file has been compressed, otherwise false.
+    */
+   static bool gzipFile(const QString &source, const QString &destination);
+
+   /**
+    * @brief applyRetention Removes the oldest rotated files of a destination that exceed the retention. The files are
+    * kept from the newest one until a limit is reached, and all the older ones are removed.
+    * @param fileDestination The complete path of the log file.
+    * @param maxFiles The maximum amount of rotated files, zero for no limit.
+    * @param maxTotalSize The maximum amount of bytes of all the rotated files, zero for no limit.
+    * @param maxAgeDays The maximum age in days of a rotated file, zero for no limit.
+    */
+   static void applyRetention(const QString &fileDestination, int maxFiles, qint64 maxTotalSize, int maxAgeDays);
+
+   /**
+    * @brief rotatedFiles Gets the rotated files of a destination that are not compressed.
+    * @param fileDestination The complete path of the log file.
+    * @return The complete paths of the files, the oldest first.
+    */
+   static QStringList rotatedFiles(const QString &fileDestination);
+
+private:
+   /**
+    * @brief Runs the archive tasks one after the other.
+    */
+   QThreadPool mPool;
+   LogCompression mCompression = LogCompression::None;
+   int mMaxFiles = 0;
+   qint64 mMaxTotalSize = 0;
+   int mMaxAgeDays = 0;
+   /**
+    * @brief Next number for a rotated file, 0 until the folder has been scanned.
+    */
+   int mNextSuffixNumber = 0;
+};
+
+}
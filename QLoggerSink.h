@@ -0,0 +1,86 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QLoggerLevel.h>
+#include <QLoggerRecord.h>
+
+#include <QVector>
+
+#include <atomic>
+
+namespace QLogger
+{
+
+class QLoggerFormatter;
+
+/**
+ * @brief The QLoggerSink class is an output of a writer. The writer hands every batch to each of its sinks from the
+ * thread that writes it, so a sink never needs a lock of its own and a network sink can send a batch at once.
+ *
+ * A sink only receives the messages accepted by its writer, filtered again by the level of the sink.
+ */
+class QLoggerSink
+{
+public:
+   virtual ~QLoggerSink() = default;
+
+   /**
+    * @brief getLevel Gets the minimum level of the messages the sink receives.
+    * @return The level
+    */
+   LogLevel getLevel() const { return mLevel.load(std::memory_order_relaxed); }
+
+   /**
+    * @brief setLevel Sets the minimum level of the messages the sink receives. It can be changed from any thread.
+    * @param level The level
+    */
+   void setLevel(LogLevel level) { mLevel.store(level, std::memory_order_relaxed); }
+
+   /**
+    * @brief accepts Checks if a message of the given level goes to the sink.
+    */
+   bool accepts(LogLevel level) const { return level >= getLevel(); }
+
+   /**
+    * @brief write Writes a batch of messages.
+    * @param records The records of the batch, all of them accepted by the sink, in the order they were logged.
+    * @param formatter The formatter with the layout of the writer, to render the records as text.
+    */
+   virtual void write(const QVector<LogRecord> &records, QLoggerFormatter &formatter) = 0;
+
+   /**
+    * @brief flush Hands the data buffered by the sink to its output. It is called when the writer is flushed.
+    */
+   virtual void flush() { }
+
+   /**
+    * @brief close Releases the output. It is called once by the writer when it stops, before the sink is destroyed.
+    */
+   virtual void close() { }
+
+private:
+   std::atomic<LogLevel> mLevel { LogLevel::Trace };
+};
+
+}
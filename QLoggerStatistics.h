@@ -0,0 +1,68 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QString>
+#include <QStringList>
+
+namespace QLogger
+{
+
+/**
+ * @brief The WriterStatistics struct is a snapshot of the counters of one QLoggerWriter. The counters are updated
+ * with relaxed atomics, so the values of one snapshot are not taken at exactly the same instant.
+ */
+struct WriterStatistics
+{
+   QString fileDestination;
+   QStringList modules;
+
+   quint64 enqueuedMessages = 0;
+   quint64 writtenMessages = 0;
+   /**
+    * @brief Messages dropped because the queue was full, whatever the queue policy.
+    */
+   quint64 droppedMessages = 0;
+
+   int queueDepth = 0;
+   int maxQueueDepth = 0;
+
+   /**
+    * @brief Bytes written in the log files, the console is not counted.
+    */
+   quint64 bytesWritten = 0;
+   quint64 batches = 0;
+   int lastBatchSize = 0;
+   int maxBatchSize = 0;
+   /**
+    * @brief Time spent by the writer formatting and writing the batches.
+    */
+   qint64 writeTimeNs = 0;
+   quint64 rotations = 0;
+   /**
+    * @brief Time spent by the logging threads waiting for room in a full queue.
+    */
+   qint64 enqueueWaitNs = 0;
+};
+
+}
@@ -0,0 +1,24 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+SOURCES += \
+        main.cpp
+
+# Build with "qmake CONFIG+=tsan" to run the stress test under ThreadSanitizer
+tsan {
+    QMAKE_CXXFLAGS += -fsanitize=thread -fno-omit-frame-pointer -g -O1
+    QMAKE_LFLAGS += -fsanitize=thread
+}
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+
+!build_pass:message("QLoggerStressTest: importing QLogger")
+if( !include($$PWD/../QLogger.pri) ) {
+    error( Could not find the QLogger.pri file. )
+}
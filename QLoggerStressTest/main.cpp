@@ -0,0 +1,432 @@
+#include <QLogger.h>
+#include <QLoggerDataEnd.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace QLogger;
+
+namespace
+{
+/**
+ * @brief The Settings struct holds the size of the run.
+ */
+struct Settings
+{
+   int producers = 8;
+   int messages = 50000;
+   int destinations = 3;
+   int toggleIntervalMs = 2;
+};
+
+qint64 now()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+       .count();
+}
+
+QString moduleName(int destination)
+{
+   return QString("stress.%1").arg(destination);
+}
+
+/**
+ * @brief Every producer spreads its messages over all the destinations.
+ */
+int destinationOf(const Settings &settings, int producer, int sequence)
+{
+   return (producer + sequence) % settings.destinations;
+}
+
+/**
+ * @brief Debug and Info are filtered out while the level is raised, Warning and Error are always logged.
+ */
+LogLevel levelOf(int sequence)
+{
+   static const LogLevel levels[] = { LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error };
+
+   return levels[sequence % 4];
+}
+
+QString levelName(LogLevel level)
+{
+   switch (level)
+   {
+      case LogLevel::Trace:
+         return QStringLiteral("Trace");
+      case LogLevel::Debug:
+         return QStringLiteral("Debug");
+      case LogLevel::Info:
+         return QStringLiteral("Info");
+      case LogLevel::Warning:
+         return QStringLiteral("Warning");
+      case LogLevel::Error:
+         return QStringLiteral("Error");
+      case LogLevel::Fatal:
+         return QStringLiteral("Fatal");
+   }
+
+   return QString();
+}
+
+/**
+ * @brief The text of a message changes in length and content with the producer and the sequence, so a line mixed
+ * with another one does not match.
+ */
+QByteArray payload(int producer, int sequence)
+{
+   return QByteArray(8 + (sequence * 7 + producer) % 120, static_cast<char>('a' + (producer + sequence) % 26));
+}
+
+/**
+ * @brief The Checker class validates the lines of the log files against the messages that can have been logged, and
+ * counts the errors found.
+ */
+class Checker
+{
+public:
+   explicit Checker(const Settings &settings)
+      : mSettings(settings)
+      , mSeen(static_cast<size_t>(settings.producers) * static_cast<size_t>(settings.messages), 0)
+   {
+   }
+
+   int errors() const { return mErrors; }
+
+   void error(const QString &text)
+   {
+      // The first errors are enough to find the cause, the rest are only counted
+      if (mErrors++ < 20)
+         std::fprintf(stderr, "%s\n", qPrintable(text));
+   }
+
+   /**
+    * @brief Validates the lines of one file of a destination.
+    * @return The amount of messages found in the file.
+    */
+   qint64 checkFile(int destination, const QString &path)
+   {
+      QFile file(path);
+
+      if (!file.open(QIODevice::ReadOnly))
+      {
+         error(QString("%1: cannot be read").arg(path));
+         return 0;
+      }
+
+      auto data = file.readAll();
+      qint64 dataEnd = 0;
+
+      // A memory-mapped file still open is preallocated after its data, its marker tells where the data ends
+      if (QLoggerDataEnd::read(path, dataEnd) && dataEnd < data.size())
+         data.truncate(static_cast<int>(dataEnd));
+
+      if (!data.isEmpty() && !data.endsWith('\n'))
+         error(QString("%1: the last line is cut").arg(path));
+
+      // The queue is FIFO, so the sequence numbers of a producer only grow within a file
+      std::vector<int> lastSequence(static_cast<size_t>(mSettings.producers), -1);
+      const auto lines = data.split('\n');
+      qint64 found = 0;
+
+      for (auto i = 0; i < lines.size(); ++i)
+      {
+         const auto &line = lines.at(i);
+
+         if (line.isEmpty() || line.startsWith("Previous log "))
+            continue;
+
+         auto producer = -1;
+         auto sequence = -1;
+
+         // The files are never written in text mode, a carriage return means the line endings are translated again
+         if (line.contains('\r') || !parseLine(destination, line, producer, sequence))
+         {
+            error(QString("%1:%2: malformed line \"%3\"").arg(path).arg(i + 1).arg(QString::fromUtf8(line.left(200))));
+            continue;
+         }
+
+         auto &seen = mSeen[static_cast<size_t>(producer) * static_cast<size_t>(mSettings.messages)
+                            + static_cast<size_t>(sequence)];
+
+         if (seen)
+            error(QString("%1:%2: duplicated message p=%3 s=%4").arg(path).arg(i + 1).arg(producer).arg(sequence));
+
+         if (sequence <= lastSequence[static_cast<size_t>(producer)])
+            error(QString("%1:%2: message p=%3 s=%4 out of order").arg(path).arg(i + 1).arg(producer).arg(sequence));
+
+         seen = 1;
+         lastSequence[static_cast<size_t>(producer)] = sequence;
+         ++found;
+      }
+
+      return found;
+   }
+
+private:
+   const Settings &mSettings;
+   std::vector<char> mSeen;
+   int mErrors = 0;
+
+   /**
+    * @brief Checks that a line is exactly the one of a message: "[Level][module] p=<producer> s=<sequence> <payload>".
+    */
+   bool parseLine(int destination, const QByteArray &line, int &producer, int &sequence) const
+   {
+      const auto parts = line.split(' ');
+
+      if (parts.size() != 4 || !parts.at(1).startsWith("p=") || !parts.at(2).startsWith("s="))
+         return false;
+
+      auto isNumber = false;
+      producer = parts.at(1).mid(2).toInt(&isNumber);
+
+      if (!isNumber || producer < 0 || producer >= mSettings.producers)
+         return false;
+
+      sequence = parts.at(2).mid(2).toInt(&isNumber);
+
+      if (!isNumber || sequence < 0 || sequence >= mSettings.messages)
+         return false;
+
+      const auto header = QString("[%1][%2]").arg(levelName(levelOf(sequence)), moduleName(destination)).toUtf8();
+
+      return destinationOf(mSettings, producer, sequence) == destination && parts.at(0) == header
+          && parts.at(3) == payload(producer, sequence);
+   }
+};
+
+void produce(const Settings &settings, int producer, const std::vector<QLoggerModule> &modules,
+             const std::atomic<bool> &go)
+{
+   QLoggerManager::setThreadName(QString("producer-%1").arg(producer));
+
+   while (!go)
+      std::this_thread::yield();
+
+   for (auto sequence = 0; sequence < settings.messages; ++sequence)
+   {
+      const auto module = modules[static_cast<size_t>(destinationOf(settings, producer, sequence))];
+      const auto message = QString("p=%1 s=%2 %3")
+                               .arg(QString::number(producer), QString::number(sequence),
+                                    QString::fromLatin1(payload(producer, sequence)));
+
+      switch (levelOf(sequence))
+      {
+         case LogLevel::Debug:
+            QLog_Debug(module, message);
+            break;
+         case LogLevel::Info:
+            QLog_Info(module, message);
+            break;
+         case LogLevel::Warning:
+            QLog_Warning(module, message);
+            break;
+         default:
+            QLog_Error(module, message);
+            break;
+      }
+   }
+}
+
+/**
+ * @brief Pauses and resumes the writers, and changes their level and their maximum file size, until the producers
+ * are done. The small file sizes keep the files rotating.
+ * @return The amount of changes done.
+ */
+int toggle(const Settings &settings, const std::atomic<bool> &done)
+{
+   const auto manager = QLoggerManager::getInstance();
+   auto toggles = 0;
+
+   while (!done)
+   {
+      const auto raised = toggles % 2 == 1;
+
+      manager->pause();
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      manager->resume();
+
+      manager->overwriteLogLevel(raised ? LogLevel::Warning : LogLevel::Trace);
+      manager->overwriteMaxFileSize(raised ? 32 * 1024 : 128 * 1024);
+
+      ++toggles;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(settings.toggleIntervalMs));
+   }
+
+   return toggles;
+}
+}
+
+int main(int argc, char *argv[])
+{
+   QCoreApplication app(argc, argv);
+   QCoreApplication::setApplicationName(QStringLiteral("QLoggerStressTest"));
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription(
+       QStringLiteral("Logs from many threads into several destinations while pausing, resuming, changing the level "
+                      "and rotating the files, then checks that every message enqueued is written once and whole. "
+                      "Prints the throughput as one JSON object and exits with 1 on error."));
+   parser.addHelpOption();
+
+   const QCommandLineOption producersOption(QStringLiteral("producers"), QStringLiteral("Amount of producer threads."),
+                                            QStringLiteral("count"),
+                                            QString::number(qMax(4, 2 * QThread::idealThreadCount())));
+   const QCommandLineOption messagesOption(QStringLiteral("messages"),
+                                           QStringLiteral("Messages logged by each producer."),
+                                           QStringLiteral("count"), QStringLiteral("50000"));
+   const QCommandLineOption destinationsOption(QStringLiteral("destinations"),
+                                               QStringLiteral("Amount of destinations."), QStringLiteral("count"),
+                                               QStringLiteral("3"));
+   const QCommandLineOption poolOption(QStringLiteral("writer-threads"),
+                                       QStringLiteral("Writer threads shared by the destinations, 0 for one each."),
+                                       QStringLiteral("count"), QStringLiteral("0"));
+   const QCommandLineOption intervalOption(QStringLiteral("toggle-interval"),
+                                           QStringLiteral("Milliseconds between two changes of the writers."),
+                                           QStringLiteral("ms"), QStringLiteral("2"));
+   const QCommandLineOption folderOption(QStringLiteral("folder"),
+                                         QStringLiteral("Folder for the log files, removed at the end if no error."),
+                                         QStringLiteral("path"),
+                                         QDir::temp().filePath(QStringLiteral("QLoggerStressTest")));
+
+   parser.addOption(producersOption);
+   parser.addOption(messagesOption);
+   parser.addOption(destinationsOption);
+   parser.addOption(poolOption);
+   parser.addOption(intervalOption);
+   parser.addOption(folderOption);
+   parser.process(app);
+
+   Settings settings;
+   settings.producers = qMax(1, parser.value(producersOption).toInt());
+   settings.messages = qMax(1, parser.value(messagesOption).toInt());
+   settings.destinations = qMax(1, parser.value(destinationsOption).toInt());
+   settings.toggleIntervalMs = qMax(0, parser.value(intervalOption).toInt());
+
+   const auto root = parser.value(folderOption);
+
+   QDir(root).removeRecursively();
+
+   const auto manager = QLoggerManager::getInstance();
+   manager->setWriterThreadPoolSize(qMax(0, parser.value(poolOption).toInt()));
+   manager->setDefaultMaxFileSize(128 * 1024);
+   manager->setDefaultIndexInterval(16 * 1024);
+
+   // Each destination writes its files in another way
+   static const LogFileAccess accesses[]
+       = { LogFileAccess::OpenPerBatch, LogFileAccess::Persistent, LogFileAccess::MemoryMapped };
+
+   std::vector<QLoggerModule> modules;
+   QStringList folders;
+
+   for (auto destination = 0; destination < settings.destinations; ++destination)
+   {
+      folders.append(QDir(root).filePath(QString("destination_%1").arg(destination)));
+
+      manager->setDefaultFileAccess(accesses[destination % 3]);
+      manager->addDestination(QString("stress_%1.log").arg(destination), moduleName(destination), LogLevel::Trace,
+                              folders.constLast(), LogMode::OnlyFile, LogFileDisplay::Number,
+                              LogMessageDisplay::LogLevel | LogMessageDisplay::ModuleName | LogMessageDisplay::Message,
+                              false);
+
+      modules.push_back(manager->module(moduleName(destination)));
+   }
+
+   std::atomic<bool> go { false };
+   std::atomic<bool> done { false };
+   std::vector<std::thread> producers;
+
+   for (auto producer = 0; producer < settings.producers; ++producer)
+      producers.emplace_back(produce, std::cref(settings), producer, std::cref(modules), std::cref(go));
+
+   auto toggles = 0;
+   std::thread toggler([&]() { toggles = toggle(settings, done); });
+
+   const auto start = now();
+   go = true;
+
+   for (auto &producer : producers)
+      producer.join();
+
+   const auto elapsedNs = now() - start;
+
+   done = true;
+   toggler.join();
+
+   // Nothing is written while paused, and the messages already enqueued are kept
+   manager->resume();
+   manager->overwriteLogLevel(LogLevel::Trace);
+
+   Checker checker(settings);
+   const auto flushStart = now();
+
+   if (!manager->flush(60000))
+      checker.error(QStringLiteral("The writers have not written the messages in 60 seconds"));
+
+   const auto drainMs = (now() - flushStart) / (1000 * 1000);
+   const auto statistics = manager->getStatistics();
+   qint64 written = 0;
+   quint64 rotations = 0;
+
+   for (auto destination = 0; destination < settings.destinations; ++destination)
+   {
+      qint64 found = 0;
+      const auto files = QDir(folders.at(destination)).entryInfoList({ QStringLiteral("*.log") }, QDir::Files);
+
+      for (const auto &file : files)
+         found += checker.checkFile(destination, file.absoluteFilePath());
+
+      for (const auto &writer : statistics)
+      {
+         if (!writer.modules.contains(moduleName(destination)))
+            continue;
+
+         // Whatever passed the level and the pause has to be in the files, exactly once
+         if (writer.droppedMessages != 0)
+            checker.error(QString("%1: %2 messages dropped").arg(writer.fileDestination).arg(writer.droppedMessages));
+
+         if (writer.writtenMessages != writer.enqueuedMessages
+             || static_cast<quint64>(found) != writer.enqueuedMessages)
+         {
+            checker.error(QString("%1: %2 messages enqueued, %3 written, %4 found in the files")
+                              .arg(writer.fileDestination)
+                              .arg(writer.enqueuedMessages)
+                              .arg(writer.writtenMessages)
+                              .arg(found));
+         }
+
+         rotations += writer.rotations;
+      }
+
+      written += found;
+   }
+
+   const auto seconds = static_cast<double>(elapsedNs) / 1e9;
+   const auto logged = static_cast<qint64>(settings.producers) * settings.messages;
+
+   std::printf("{\"stress\":\"%s\",\"producers\":%d,\"destinations\":%d,\"messages\":%lld,\"written\":%lld,"
+               "\"seconds\":%.6f,\"messages_per_second\":%.0f,\"drain_ms\":%lld,\"toggles\":%d,\"rotations\":%llu,"
+               "\"errors\":%d}\n",
+               checker.errors() == 0 ? "passed" : "failed", settings.producers, settings.destinations,
+               static_cast<long long>(logged), static_cast<long long>(written), seconds,
+               seconds > 0 ? static_cast<double>(logged) / seconds : 0.0, static_cast<long long>(drainMs), toggles,
+               static_cast<unsigned long long>(rotations), checker.errors());
+   std::fflush(stdout);
+
+   // The files are kept to look into the errors
+   if (checker.errors() == 0)
+      QDir(root).removeRecursively();
+
+   return checker.errors() == 0 ? 0 : 1;
+}
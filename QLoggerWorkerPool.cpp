@@ -0,0 +1,121 @@
+#include "QLoggerWorkerPool.h"
+
+#include "QLoggerWriter.h"
+
+#include <QThread>
+
+namespace QLogger
+{
+
+class QLoggerWorkerPool::Worker : public QThread
+{
+public:
+   explicit Worker(QLoggerWorkerPool *pool)
+      : mPool(pool)
+   {
+   }
+
+   void run() override { mPool->work(); }
+
+private:
+   QLoggerWorkerPool *mPool;
+};
+
+QLoggerWorkerPool::QLoggerWorkerPool(int size)
+{
+   for (auto i = 0; i < qMax(1, size); ++i)
+   {
+      const auto worker = new Worker(this);
+      worker->setObjectName(QString("QLoggerWorker-%1").arg(i));
+      worker->start();
+
+      mWorkers.append(worker);
+   }
+}
+
+QLoggerWorkerPool::~QLoggerWorkerPool()
+{
+   stop();
+}
+
+void QLoggerWorkerPool::addWriter(QLoggerWriter *writer)
+{
+   QMutexLocker locker(&mMutex);
+
+   mWriters.append(writer);
+}
+
+void QLoggerWorkerPool::schedule(QLoggerWriter *writer)
+{
+   QMutexLocker locker(&mMutex);
+
+   if (enqueueWriter(writer))
+      mWriterReady.wakeOne();
+}
+
+bool QLoggerWorkerPool::enqueueWriter(QLoggerWriter *writer)
+{
+   if (mQuit || writer->mScheduled.exchange(true, std::memory_order_acq_rel))
+      return false;
+
+   mReadyWriters.enqueue(writer);
+
+   return true;
+}
+
+void QLoggerWorkerPool::stop()
+{
+   {
+      QMutexLocker locker(&mMutex);
+      mQuit = true;
+      mWriterReady.wakeAll();
+   }
+
+   for (const auto worker : std::as_const(mWorkers))
+   {
+      worker->wait();
+      delete worker;
+   }
+
+   mWorkers.clear();
+}
+
+void QLoggerWorkerPool::work()
+{
+   QMutexLocker locker(&mMutex);
+
+   while (!mQuit)
+   {
+      if (mReadyWriters.isEmpty())
+      {
+         // When idle, every writer gets a visit so the data buffered in persistent files is flushed on time
+         if (!mWriterReady.wait(&mMutex, IdleInterval))
+         {
+            for (const auto writer : std::as_const(mWriters))
+               enqueueWriter(writer);
+         }
+
+         continue;
+      }
+
+      const auto writer = mReadyWriters.dequeue();
+
+      locker.unlock();
+
+      writer->processBatch(MaxBatchSize);
+      writer->mScheduled.store(false, std::memory_order_release);
+
+      locker.relock();
+
+      // Writers with more messages go back to the end of the queue. A flush requested during the batch was ignored by
+      // schedule, since the writer was still marked, so it is served on the next visit as well.
+      if (writer->hasPendingMessages()
+          || (!writer->isStop()
+              && (writer->hasFlushRequest() || writer->mMemoryDumpRequest.load(std::memory_order_acquire))))
+      {
+         enqueueWriter(writer);
+      }
+   }
+}
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+/****************************************************************************************
+ ** QLogger is a library to register and print logs into a file.
+ ** Copyright (C) 2022 Francesc Martinez
+ **
+ ** LinkedIn: www.linkedin.com/in/cescmm/
+ ** Web: www.francescmm.com
+ **
+ ** This library is free software; you can redistribute it and/or
+ ** modify it under the terms of the GNU Lesser General Public
+ ** License as published by the Free Software Foundation; either
+ ** version 2 of the License, or (at your option) any later version.
+ **
+ ** This library is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ ** Lesser General Public License for more details.
+ **
+ ** You should have received a copy of the GNU Lesser General Public
+ ** License along with this library; if not, write to the Free Software
+ ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***************************************************************************************/
+
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include <QWaitCondition>
+
+class QThread;
+
+namespace QLogger
+{
+
+class QLoggerWriter;
+
+/**
+ * @brief The QLoggerWorkerPool class writes the messages of several QLoggerWriter with a fixed amount of threads.
+ * The writers with pending messages are served in order of arrival and each visit writes a limited batch, so a
+ * writer with many messages cannot starve the others.
+ */
+class QLoggerWorkerPool
+{
+public:
+   /**
+    * @brief Constructor that starts the worker threads.
+    * @param size The amount of worker threads.
+    */
+   explicit QLoggerWorkerPool(int size);
+
+   /**
+    * @brief Destructor. Stops the worker threads.
+    */
+   ~QLoggerWorkerPool();
+
+   QLoggerWorkerPool(const QLoggerWorkerPool &) = delete;
+   QLoggerWorkerPool &operator=(const QLoggerWorkerPool &) = delete;
+
+   /**
+    * @brief addWriter Registers a writer that will be served by the pool.
+    * @param writer The writer.
+    */
+   void addWriter(QLoggerWriter *writer);
+
+   /**
+    * @brief schedule Queues a writer that has pending messages. A writer is never queued twice.
+    * @param writer The writer.
+    */
+   void schedule(QLoggerWriter *writer);
+
+   /**
+    * @brief stop Stops the worker threads and waits for them. The writers that are still queued are not served.
+    */
+   void stop();
+
+private:
+   class Worker;
+
+   /**
+    * @brief Maximum amount of messages written for a writer before serving the next one.
+    */
+   static const int MaxBatchSize = 512;
+   /**
+    * @brief Time in milliseconds after which idle workers check the writers with buffered data to flush.
+    */
+   static const int IdleInterval = 100;
+
+   bool mQuit = false;
+   QMutex mMutex;
+   QWaitCondition mWriterReady;
+   QQueue<QLoggerWriter *> mReadyWriters;
+   QVector<QLoggerWriter *> mWriters;
+   QVector<QThread *> mWorkers;
+
+   /**
+    * @brief work Main loop of a worker thread.
+    */
+   void work();
+
+   /**
+    * @brief Queues the writer if it is not already. Must be called with mMutex held.
+    * @param writer The writer.
+    * @return True if the writer has been queued.
+    */
+   bool enqueueWriter(QLoggerWriter *writer);
+};
+
+}
@@ -1,39 +1,26 @@
 #include "QLoggerWriter.h"
 
+#include "QLoggerWorkerPool.h"
+
 #include <QDateTime>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
 #include <QDir>
-#include <QDebug>
+#include <QDeadlineTimer>
 
-namespace
-{
-/**
- * @brief Converts the given level in a QString.
- * @param level The log level in LogLevel format.
- * @return The string with the name of the log level.
- */
-QString levelToText(const QLogger::LogLevel &level)
-{
-   switch (level)
-   {
-      case QLogger::LogLevel::Trace:
-         return "Trace";
-      case QLogger::LogLevel::Debug:
-         return "Debug";
-      case QLogger::LogLevel::Info:
-         return "Info";
-      case QLogger::LogLevel::Warning:
-         return "Warning";
-      case QLogger::LogLevel::Error:
-         return "Error";
-      case QLogger::LogLevel::Fatal:
-         return "Fatal";
-   }
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <limits>
 
-   return QString();
-}
-}
+#include <fcntl.h>
+
+#ifdef Q_OS_WIN
+#   include <io.h>
+#   include <sys/stat.h>
+#else
+#   include <unistd.h>
+#endif
 
 namespace QLogger
 {
@@ -43,221 +30,1033 @@ QLoggerWriter::QLoggerWriter(const QString &fileDestination, LogLevel level, con
    : mFileSuffixIfFull(fileSuffixIfFull)
    , mMode(mode)
    , mLevel(level)
-   , mMessageOptions(messageOptions)
 {
-   mFileDestinationFolder = fileFolderDestination.isEmpty() ? QDir::currentPath() + "/logs/" : fileFolderDestination;
+   const auto config = new WriterConfig();
+   config->messageOptions = messageOptions;
+   mConfig.store(config, std::memory_order_release);
+
+   mFileDestinationFolder = resolveFileDestinationFolder(fileFolderDestination);
+   mFileDestination = resolveFileDestination(fileDestination, fileFolderDestination);
+   mDumpPath = QFile::encodeName(mFileDestination);
 
-   if (!mFileDestinationFolder.endsWith("/"))
-      mFileDestinationFolder.append("/");
+   // The memory can be dumped from a crash handler, so its folder is created in advance as well
+   if (mMode != LogMode::Disabled && mMode != LogMode::OnlyConsole)
+      QDir(mFileDestinationFolder).mkpath(QStringLiteral("."));
+}
+
+QLoggerWriter::~QLoggerWriter()
+{
+   // The sinks are only referenced by the configurations, the latest one has all of them
+   if (const auto config = mConfig.load())
+      qDeleteAll(config->sinks);
 
-   mFileDestination = mFileDestinationFolder + fileDestination;
+   delete mConfig.exchange(nullptr);
+
+   qDeleteAll(mRetiredConfigs);
+   mRetiredConfigs.clear();
+}
+
+QLoggerWriter::ConfigReference::ConfigReference(const QLoggerWriter &writer)
+   : mReaders(&writer.mConfigReaders)
+{
+   // Counted before the load: a change that retires this configuration afterwards sees the reader
+   mReaders->fetch_add(1, std::memory_order_seq_cst);
+   mConfig = writer.mConfig.load(std::memory_order_seq_cst);
+}
+
+QLoggerWriter::ConfigReference::~ConfigReference()
+{
+   if (mReaders)
+      mReaders->fetch_sub(1, std::memory_order_release);
+}
+
+void QLoggerWriter::releaseRetiredConfigs()
+{
+   // A reader counted from now on can only load the current configuration, so without readers none of the retired
+   // ones is in use
+   if (mRetiredConfigs.isEmpty() || mConfigReaders.load(std::memory_order_seq_cst) > 0)
+      return;
+
+   qDeleteAll(mRetiredConfigs);
+   mRetiredConfigs.clear();
+   mHasRetiredConfigs.store(false, std::memory_order_relaxed);
+}
+
+QString QLoggerWriter::resolveFileDestinationFolder(const QString &fileFolderDestination)
+{
+   auto folder = fileFolderDestination.isEmpty() ? QDir::currentPath() + "/logs/" : fileFolderDestination;
+
+   if (!folder.endsWith("/"))
+      folder.append("/");
+
+   return folder;
+}
+
+QString QLoggerWriter::resolveFileDestination(const QString &fileDestination, const QString &fileFolderDestination)
+{
+   const auto folder = resolveFileDestinationFolder(fileFolderDestination);
 
-   QDir dir(mFileDestinationFolder);
    if (fileDestination.isEmpty())
    {
-      mFileDestination = dir.filePath(QString::fromLatin1("%1.log").arg(
+      return QDir(folder).filePath(QString::fromLatin1("%1.log").arg(
           QDateTime::currentDateTime().date().toString(QString::fromLatin1("yyyy-MM-dd"))));
    }
-   else if (!fileDestination.contains(QLatin1Char('.')))
-      mFileDestination.append(QString::fromLatin1(".log"));
 
-   if (mMode == LogMode::Full || mMode == LogMode::OnlyFile)
-      dir.mkpath(QStringLiteral("."));
+   auto destination = folder + fileDestination;
+
+   if (!fileDestination.contains(QLatin1Char('.')))
+      destination.append(QString::fromLatin1(".log"));
+
+   return destination;
 }
 
 void QLoggerWriter::setLogMode(LogMode mode)
 {
    mMode = mode;
 
-   if (mMode == LogMode::Full || mMode == LogMode::OnlyFile)
+   if (mMode != LogMode::Disabled && mMode != LogMode::OnlyConsole)
    {
       QDir dir(mFileDestinationFolder);
       dir.mkpath(QStringLiteral("."));
    }
 
-   if (mode != LogMode::Disabled && !this->isRunning())
+   if (mode != LogMode::Disabled && !mWorkerPool && !this->isRunning())
       start();
 }
 
+void QLoggerWriter::setFlushPolicy(int flushSize, int flushInterval)
+{
+   updateConfig([flushSize, flushInterval](WriterConfig &config) {
+      config.flushSize = flushSize;
+      config.flushInterval = flushInterval;
+   });
+}
+
 QString QLoggerWriter::renameFileIfFull()
 {
    QFile file(mFileDestination);
 
    // Rename file if it's full
-   if (file.size() >= mMaxFileSize)
-   {
-      QString newName;
+   if (file.size() >= currentConfig()->maxFileSize)
+      return renameFile();
 
-      const auto fileDestination = mFileDestination.left(mFileDestination.lastIndexOf('.'));
-      const auto fileExtension = mFileDestination.mid(mFileDestination.lastIndexOf('.') + 1);
+   return QString();
+}
 
-      if (mFileSuffixIfFull == LogFileDisplay::DateTime)
-      {
-         newName
-             = QString("%1_%2.%3")
-                   .arg(fileDestination, QDateTime::currentDateTime().toString("dd_MM_yy__hh_mm_ss"), fileExtension);
-      }
-      else
-         newName = generateDuplicateFilename(fileDestination, fileExtension);
+QString QLoggerWriter::renameFile()
+{
+   QString newName;
 
-      const auto renamed = file.rename(mFileDestination, newName);
+   const auto fileDestination = mFileDestination.left(mFileDestination.lastIndexOf('.'));
+   const auto fileExtension = mFileDestination.mid(mFileDestination.lastIndexOf('.') + 1);
 
-      return renamed ? newName : QString();
+   if (mFileSuffixIfFull == LogFileDisplay::DateTime)
+   {
+      newName = QString("%1_%2.%3")
+                    .arg(fileDestination, QDateTime::currentDateTime().toString("dd_MM_yy__hh_mm_ss"), fileExtension);
    }
+   else
+      newName = mRotation.generateDuplicateFilename(fileDestination, fileExtension);
 
-   return QString();
+   mIndex.close();
+
+   // Only the rename is done by the writer thread, the compression and the retention are done in the background
+   if (!QFile::rename(mFileDestination, newName))
+      return QString();
+
+   // The index follows its file, a compressed file is not indexed
+   const auto indexPath = QLoggerIndex::indexPath(mFileDestination);
+
+   if (mRotation.getCompression() == LogCompression::Gzip)
+      QFile::remove(indexPath);
+   else
+      QFile::rename(indexPath, QLoggerIndex::indexPath(newName));
+
+   mRotations.fetch_add(1, std::memory_order_relaxed);
+
+   return mRotation.archive(mFileDestination, newName);
 }
 
-QString QLoggerWriter::generateDuplicateFilename(const QString &fileDestination, const QString &fileExtension,
-                                                 int fileSuffixNumber)
+void QLoggerWriter::write(const QVector<LogRecord> &records)
 {
-   QString path(fileDestination);
-   if (fileSuffixNumber > 1)
-      path = QString("%1(%2).%3").arg(fileDestination, QString::number(fileSuffixNumber), fileExtension);
+   if (mMode == LogMode::OnlyConsole)
+   {
+      closeFile();
+      writeToSink(mConsole, records);
+   }
+   else if (mMode == LogMode::Memory)
+      writeToMemory(records);
    else
-      path.append(QString(".%1").arg(fileExtension));
+   {
+      if (mFileFormat == LogFileFormat::Binary)
+         writeToBinaryFile(records);
+      else if (mFileAccess != LogFileAccess::OpenPerBatch)
+         writeToOpenFile(records);
+      else
+         writeToFilePerBatch(records);
+
+      // With LogMode::Full the console lines have been gathered along with the lines of the file
+      mConsole.flush();
+   }
 
-   // A name already exists, increment the number and check again
-   if (QFileInfo::exists(path))
-      return generateDuplicateFilename(fileDestination, fileExtension, fileSuffixNumber + 1);
+   const auto config = currentConfig();
 
-   // No file exists at the given location, so no need to continue
-   return path;
+   for (const auto sink : config->sinks)
+      writeToSink(*sink, records);
 }
 
-void QLoggerWriter::write(QVector<QString> messages)
+void QLoggerWriter::writeToSink(QLoggerSink &sink, const QVector<LogRecord> &records)
 {
-   // Write data to console
-   if (mMode == LogMode::OnlyConsole)
+   // Most sinks accept every message of the writer and get the batch as it is
+   const auto acceptsAll = std::all_of(records.cbegin(), records.cend(),
+                                       [&sink](const LogRecord &record) { return sink.accepts(record.level); });
+
+   if (acceptsAll)
+   {
+      sink.write(records, mFormatter);
+      return;
+   }
+
+   mSinkRecords.resize(0);
+
+   for (const auto &record : records)
    {
-      for (const auto &message : messages)
-         qInfo() << message;
+      if (sink.accepts(record.level))
+         mSinkRecords.append(record);
+   }
+
+   if (!mSinkRecords.isEmpty())
+      sink.write(mSinkRecords, mFormatter);
 
+   mSinkRecords.resize(0);
+}
+
+void QLoggerWriter::writeToMemory(const QVector<LogRecord> &records)
+{
+   closeFile();
+
+   const auto capacity = currentConfig()->memoryCapacity;
+
+   if (mMemory.capacity() != capacity)
+      mMemory.setCapacity(capacity);
+
+   // Binary records could not be decoded once their strings are overwritten, the memory is always rendered as text
+   for (const auto &record : records)
+      mFormatter.appendMessage(record, mWriteBuffer);
+
+   mMemory.append(mWriteBuffer.constData(), mWriteBuffer.size());
+   mWriteBuffer.resize(0);
+
+   const auto hasFatal = std::any_of(records.cbegin(), records.cend(),
+                                     [](const LogRecord &record) { return record.level == LogLevel::Fatal; });
+
+   if (hasFatal)
+      writeMemoryDump();
+}
+
+void QLoggerWriter::writeMemoryDump()
+{
+   if (mMemory.isEmpty())
       return;
+
+   QFile file(mFileDestination);
+
+   const auto prevFilename = renameFileIfFull();
+
+   if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+   {
+      if (!prevFilename.isEmpty())
+         file.write(QString("Previous log %1\n").arg(prevFilename).toUtf8());
+
+      const auto written = file.write(mMemory.contents());
+
+      if (written > 0)
+         mBytesWritten.fetch_add(static_cast<quint64>(written), std::memory_order_relaxed);
+
+      if (currentConfig()->fsyncPolicy != LogFsyncPolicy::Never)
+         syncFile(file);
+
+      file.close();
    }
 
+   // The lines dumped are not written again by the next dump
+   mMemory.clear();
+}
+
+bool QLoggerWriter::dumpMemory(int timeout)
+{
+   if (mMode != LogMode::Memory)
+      return false;
+
+   mMemoryDumpRequest.store(true, std::memory_order_release);
+
+   return flush(timeout);
+}
+
+void QLoggerWriter::closeSinks()
+{
+   const auto config = currentConfig();
+
+   for (const auto sink : config->sinks)
+      sink->close();
+}
+
+void QLoggerWriter::writeToFilePerBatch(const QVector<LogRecord> &records)
+{
+   // Only a file left open by another access mode is closed, the index stays open between the batches
+   if (mFile.isOpen())
+      closeFile();
+
    // Write data to file
    QFile file(mFileDestination);
 
    const auto prevFilename = renameFileIfFull();
 
-   if (file.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Append))
+   if (file.open(QIODevice::WriteOnly | QIODevice::Append))
    {
-      QTextStream out(&file);
+      const auto fileSize = file.size();
+
+      mIndex.open(mFileDestination, fileSize);
 
       if (!prevFilename.isEmpty())
-         out << QString("Previous log %1\n").arg(prevFilename);
+         mWriteBuffer.append(QString("Previous log %1\n").arg(prevFilename).toUtf8());
+
+      appendMessages(records, fileSize);
+
+      const auto written = file.write(mWriteBuffer);
+
+      if (written > 0)
+         mBytesWritten.fetch_add(static_cast<quint64>(written), std::memory_order_relaxed);
+
+      if (mSyncBatch)
+         syncFile(file);
+
+      file.close();
+      mIndex.flush();
+   }
+
+   mWriteBuffer.resize(0);
+}
+
+bool QLoggerWriter::openFile(QString &prevFilename)
+{
+   // The size is tracked in memory: the file is only stat'ed when it is opened. The data still buffered counts as
+   // written, otherwise a large flush size lets the file grow far beyond its limit
+   const auto maxFileSize = currentConfig()->maxFileSize;
+
+   if (mFile.isOpen() && mFileSize + mWriteBuffer.size() >= maxFileSize)
+   {
+      closeFile();
+      prevFilename = renameFile();
+   }
 
-      for (const auto &message : messages)
+   if (!mFile.isOpen())
+   {
+      const auto mapped = mFileAccess == LogFileAccess::MemoryMapped;
+
+      // A mapped file left by a crash keeps its preallocated bytes, they are dropped before checking its size
+      if (mapped)
+         recoverMappedFile();
+
+      if (prevFilename.isEmpty())
+         prevFilename = renameFileIfFull();
+
+      QIODevice::OpenMode openMode = QIODevice::Unbuffered;
+
+      // Never in text mode: the offsets of the index are the ones of the buffer, and a mapped file or the crash
+      // handler write the same bytes without translating the line endings either
+      if (mapped)
+         openMode |= QIODevice::ReadWrite;
+      else
+         openMode |= QIODevice::WriteOnly | QIODevice::Append;
+
+      mFile.setFileName(mFileDestination);
+
+      if (!mFile.open(openMode))
+         return false;
+
+      mDumpHandle.store(mFile.handle(), std::memory_order_release);
+
+      mFileSize = mFile.size();
+      mLastFlush.start();
+
+      if (mapped)
       {
-         out << message;
+         mMappedSize = qMax(static_cast<qint64>(maxFileSize), mFileSize);
+
+         // The marker is created before the file grows, so preallocated bytes never exist without it
+         if (mDataEnd.open(mFileDestination, mFileSize) && mFile.resize(mMappedSize))
+            mMappedFile = mFile.map(0, mMappedSize);
 
-         if (mMode == LogMode::Full)
-            qInfo() << message;
+         // Without mapping the data is written at the end of the current one, as a persistent file
+         if (!mMappedFile)
+         {
+            mFile.resize(mFileSize);
+            mDataEnd.close();
+         }
+
+         mFile.seek(mFileSize);
       }
 
-      file.close();
+      // The string table starts again every time the file is opened, so each run can be decoded on its own
+      if (mFileFormat == LogFileFormat::Binary)
+         mEncoder.writeHeader(mWriteBuffer);
    }
+
+   return true;
 }
 
-void QLoggerWriter::enqueue(const QDateTime &date, const QString &threadId, const QString &module, LogLevel level,
-                            const QString &function, const QString &fileName, int line, const QString &message)
+void QLoggerWriter::writeToOpenFile(const QVector<LogRecord> &records)
 {
-   QMutexLocker locker(&mutex);
+   QString prevFilename;
 
-   if (mMode == LogMode::Disabled)
+   if (!openFile(prevFilename))
       return;
 
-   QString fileLine;
-   if (mMessageOptions.testFlag(LogMessageDisplay::File) && mMessageOptions.testFlag(LogMessageDisplay::Line)
-       && !fileName.isEmpty() && line > 0 && mLevel <= LogLevel::Debug)
+   mIndex.open(mFileDestination, mFileSize);
+
+   if (!prevFilename.isEmpty())
+      mWriteBuffer.append(QString("Previous log %1\n").arg(prevFilename).toUtf8());
+
+   appendMessages(records, mFileSize);
+
+   const auto config = currentConfig();
+
+   if (mMappedFile || mWriteBuffer.size() >= config->flushSize || mLastFlush.hasExpired(config->flushInterval))
+      flushFile();
+}
+
+void QLoggerWriter::appendMessages(const QVector<LogRecord> &records, qint64 fileOffset)
+{
+   for (const auto &record : records)
    {
-      fileLine = QString("{%1:%2}").arg(fileName, QString::number(line));
+      const auto start = mWriteBuffer.size();
+
+      mFormatter.appendMessage(record, mWriteBuffer);
+
+      mIndex.add(fileOffset + start, mWriteBuffer.size() - start, mFormatter.toWallTime(record.timestamp) / 1000000,
+                 record.level);
+
+      // The console gets the line already rendered instead of formatting it again
+      if (mMode == LogMode::Full && mConsole.accepts(record.level))
+      {
+         mConsole.appendLine(record.level, mWriteBuffer.constData() + start,
+                             static_cast<int>(mWriteBuffer.size() - start));
+      }
+   }
+}
+
+void QLoggerWriter::writeToBinaryFile(const QVector<LogRecord> &records)
+{
+   QString prevFilename;
+
+   if (!openFile(prevFilename))
+      return;
+
+   if (!prevFilename.isEmpty())
+      mEncoder.writeText(QString("Previous log %1").arg(prevFilename), mWriteBuffer);
+
+   for (const auto &record : records)
+   {
+      mEncoder.writeRecord(record, mFormatter.toWallTime(record.timestamp), mWriteBuffer);
+
+      if (mMode == LogMode::Full && mConsole.accepts(record.level))
+         mConsole.appendMessage(mFormatter, record);
    }
-   else if (mMessageOptions.testFlag(LogMessageDisplay::File) && mMessageOptions.testFlag(LogMessageDisplay::Function)
-            && !fileName.isEmpty() && !function.isEmpty() && mLevel <= LogLevel::Debug)
+
+   const auto config = currentConfig();
+
+   if (mMappedFile || mWriteBuffer.size() >= config->flushSize || mLastFlush.hasExpired(config->flushInterval))
+      flushFile();
+}
+
+void QLoggerWriter::recoverMappedFile()
+{
+   qint64 end = 0;
+
+   // The marker is only valid once the end has been stored, and the file is not preallocated before that
+   if (QLoggerDataEnd::read(mFileDestination, end) && QFileInfo(mFileDestination).size() > end)
+      QFile::resize(mFileDestination, end);
+
+   QFile::remove(QLoggerDataEnd::markerPath(mFileDestination));
+}
+
+void QLoggerWriter::flushFile()
+{
+   // Written by this thread from now on, the crash handler must not write the same data again
+   retractPendingData();
+
+   auto data = mWriteBuffer.constData();
+   auto size = static_cast<qint64>(mWriteBuffer.size());
+
+   if (mMappedFile && size > 0)
    {
-      fileLine = QString("{%1}{%2}").arg(fileName, function);
+      const auto copied = qBound(static_cast<qint64>(0), mMappedSize - mFileSize, size);
+
+      std::memcpy(mMappedFile + mFileSize, data, static_cast<size_t>(copied));
+      mFileSize += copied;
+      mBytesWritten.fetch_add(static_cast<quint64>(copied), std::memory_order_relaxed);
+      data += copied;
+      size -= copied;
+
+      // The rest of a batch that overflows the preallocated size is appended, and the file rotated on the next one
+      if (size > 0)
+         mFile.seek(mFileSize);
    }
 
-   QString text;
-   if (mMessageOptions.testFlag(LogMessageDisplay::Default))
+   if (mFile.isOpen() && size > 0)
    {
-      text = QString("[%1][%2][%3][%4]%5 %6")
-                 .arg(levelToText(level), module)
-                 .arg(date.toSecsSinceEpoch())
-                 .arg(threadId, fileLine, message);
+      const auto written = mFile.write(data, size);
+
+      if (written > 0)
+      {
+         mFileSize += written;
+         mBytesWritten.fetch_add(static_cast<quint64>(written), std::memory_order_relaxed);
+      }
    }
-   else
+
+   if (mMappedFile)
+      mDataEnd.store(mFileSize);
+
+   // The capacity is kept for the next batches
+   mWriteBuffer.resize(0);
+   mLastFlush.start();
+
+   // The index only describes data that is in the file
+   mIndex.flush();
+}
+
+void QLoggerWriter::publishPendingData()
+{
+   // The size is stored while the pointer is still null, and the handler checks the pointer again after reading it
+   mDumpSize.store(static_cast<qint64>(mWriteBuffer.size()), std::memory_order_seq_cst);
+   mDumpData.store(mWriteBuffer.isEmpty() ? nullptr : mWriteBuffer.constData(), std::memory_order_seq_cst);
+}
+
+void QLoggerWriter::closeFile()
+{
+   if (mFile.isOpen())
    {
-      if (mMessageOptions.testFlag(LogMessageDisplay::LogLevel))
-         text.append(QString("[%1]").arg(levelToText(level)));
+      flushFile();
+
+      if (currentConfig()->fsyncPolicy != LogFsyncPolicy::Never)
+         syncFile(mFile);
+
+      mDumpHandle.store(-1, std::memory_order_release);
+
+      if (mMappedFile)
+      {
+         mFile.unmap(mMappedFile);
+         mFile.resize(mFileSize);
+         mMappedFile = nullptr;
+
+         // The file has no preallocated bytes anymore
+         mDataEnd.close();
+      }
 
-      if (mMessageOptions.testFlag(LogMessageDisplay::ModuleName))
-         text.append(QString("[%1]").arg(module));
+      mFile.close();
+   }
 
-      if (mMessageOptions.testFlag(LogMessageDisplay::DateTime))
-         text.append(QString("[%1]").arg(date.toSecsSinceEpoch()));
+   mIndex.close();
+}
 
-      if (mMessageOptions.testFlag(LogMessageDisplay::ThreadId))
-         text.append(QString("[%1]").arg(threadId));
+void QLoggerWriter::addSink(QLoggerSink *sink)
+{
+   updateConfig([sink](WriterConfig &config) { config.sinks.append(sink); });
+}
+
+void QLoggerWriter::setFsyncPolicy(LogFsyncPolicy policy, int interval)
+{
+   updateConfig([policy, interval](WriterConfig &config) {
+      config.fsyncPolicy = policy;
+      config.fsyncInterval = interval;
+   });
+}
 
-      if (!fileLine.isEmpty())
+void QLoggerWriter::setWakePolicy(int batchSize, int maxLatency)
+{
+   mWakeBatchSize.store(batchSize, std::memory_order_relaxed);
+   mMaxWakeLatency.store(maxLatency, std::memory_order_relaxed);
+}
+
+void QLoggerWriter::setQueueCapacity(int capacity, LogQueuePolicy policy, LogLevel dropLevel)
+{
+   mDropLevel.store(dropLevel, std::memory_order_relaxed);
+   mQueuePolicy.store(policy, std::memory_order_relaxed);
+   mQueueCapacity.store(capacity, std::memory_order_relaxed);
+
+   // A producer blocked by the previous capacity checks the new one
+   QMutexLocker locker(&mutex);
+   mQueueNotFull.wakeAll();
+}
+
+bool QLoggerWriter::makeRoom(LogQueuePolicy policy, LogLevel level)
+{
+   switch (policy)
+   {
+      case LogQueuePolicy::Block:
       {
-         if (fileLine.startsWith(QChar::Space))
-            fileLine = fileLine.right(1);
+         QMutexLocker locker(&mutex);
+
+         // The capacity is read again after every wake up, a change to no limit releases the producer
+         while (!mQuit && !mIsStop && mQueueCapacity.load(std::memory_order_relaxed) > 0
+                && mPending.load(std::memory_order_acquire) >= mQueueCapacity.load(std::memory_order_relaxed))
+         {
+            mQueueNotFull.wait(&mutex);
+         }
 
-         text.append(fileLine);
+         return true;
       }
-      if (mMessageOptions.testFlag(LogMessageDisplay::Message))
+      case LogQueuePolicy::DropNewest:
+         return false;
+      case LogQueuePolicy::DropBelowLevel:
+         return level >= mDropLevel.load(std::memory_order_relaxed);
+      case LogQueuePolicy::DropOldest:
       {
-         if (text.isEmpty() || text.endsWith(QChar::Space))
-            text.append(QString("%1").arg(message));
-         else
-            text.append(QString(" %1").arg(message));
+         QMutexLocker locker(&mPopMutex);
+         LogRecord oldest;
+
+         if (mMessages.pop(oldest))
+         {
+            mPending.fetch_sub(1, std::memory_order_acq_rel);
+            mDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+            mTotalDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+            mCompletedMessages.fetch_add(1, std::memory_order_release);
+         }
+
+         return true;
       }
    }
 
-   text.append(QString::fromLatin1("\n"));
+   return true;
+}
 
-   mMessages.append(text);
+void QLoggerWriter::enqueue(LogRecord &&record, bool mayBlock)
+{
+   if (mMode == LogMode::Disabled)
+      return;
 
-   if (!mIsStop)
-      mQueueNotEmpty.wakeAll();
+   const auto capacity = mQueueCapacity.load(std::memory_order_relaxed);
+   const auto policy = mQueuePolicy.load(std::memory_order_relaxed);
+
+   // The capacity is checked without locking, so it can be exceeded by the amount of concurrent producers
+   if (capacity > 0 && mPending.load(std::memory_order_acquire) >= capacity
+       && (mayBlock || policy != LogQueuePolicy::Block))
+   {
+      const auto waitStart = LogRecord::currentTimestamp();
+      const auto accepted = makeRoom(policy, record.level);
+
+      mEnqueueWaitTime.fetch_add(LogRecord::currentTimestamp() - waitStart, std::memory_order_relaxed);
+
+      if (!accepted)
+      {
+         mDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+         mTotalDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+   }
+
+   // Counted before the push, so a flush never sees more messages written than the ones it waits for
+   mEnqueuedMessages.fetch_add(1, std::memory_order_acq_rel);
+
+   mMessages.push(std::move(record));
+
+   // Only the producer that makes the queue non-empty, or that completes a batch, needs to wake the writer up
+   const auto previous = mPending.fetch_add(1, std::memory_order_acq_rel);
+
+   // The high watermark is rarely raised, so it costs a relaxed load most of the times
+   auto maxDepth = mMaxQueueDepth.load(std::memory_order_relaxed);
+
+   while (previous + 1 > maxDepth
+          && !mMaxQueueDepth.compare_exchange_weak(maxDepth, previous + 1, std::memory_order_relaxed))
+   {
+   }
+
+   if ((previous == 0 || previous + 1 == mWakeBatchSize.load(std::memory_order_relaxed)) && !mIsStop)
+      wakeUp();
 }
 
-void QLoggerWriter::run()
+void QLoggerWriter::stop(bool stop)
+{
+   mIsStop = stop;
+
+   if (!stop && mPending.load(std::memory_order_acquire) > 0)
+      wakeUp();
+}
+
+void QLoggerWriter::wakeUp()
 {
-   if (!mQuit)
+   if (mWorkerPool)
+      mWorkerPool->schedule(this);
+   else
    {
       QMutexLocker locker(&mutex);
-      mQueueNotEmpty.wait(&mutex);
+      mQueueNotEmpty.wakeAll();
    }
+}
 
+void QLoggerWriter::run()
+{
    while (!mQuit)
    {
-      decltype(mMessages) copy;
-
       {
          QMutexLocker locker(&mutex);
-         std::swap(copy, mMessages);
-      }
 
-      write(std::move(copy));
+         // A flush request wakes the writer up even with an empty queue, to flush the buffered data
+         while (!mQuit && (mIsStop || (mPending.load(std::memory_order_acquire) <= 0 && !hasFlushRequest())))
+         {
+            if (mWriteBuffer.isEmpty())
+               mQueueNotEmpty.wait(&mutex);
+            else
+            {
+               const auto remaining = currentConfig()->flushInterval - static_cast<int>(mLastFlush.elapsed());
 
-      if (!mQuit)
-      {
-         QMutexLocker locker(&mutex);
-         mQueueNotEmpty.wait(&mutex);
+               if (!mQueueNotEmpty.wait(&mutex, qMax(1, remaining)))
+                  break;
+            }
+         }
       }
+
+      if (mQuit)
+         break;
+
+      waitForBatch();
+
+      // A producer is still linking its message into the queue
+      if (processBatch(std::numeric_limits<int>::max()) == 0 && mPending.load(std::memory_order_acquire) > 0)
+         QThread::yieldCurrentThread();
    }
+
+   // The messages already queued are written before leaving, unless the writer is paused
+   while (processBatch(std::numeric_limits<int>::max()) > 0)
+      ;
+
+   closeFile();
+   closeSinks();
+
+   // Nothing else will be written, the callers of flush do not need to wait for their timeout
+   QMutexLocker locker(&mutex);
+   mFlushedRequest.store(mFlushRequest.load(std::memory_order_acquire), std::memory_order_release);
+   mFlushDone.wakeAll();
 }
 
-void QLoggerWriter::closeDestination()
+void QLoggerWriter::waitForBatch()
 {
+   const auto wakeBatchSize = mWakeBatchSize.load(std::memory_order_relaxed);
+   const auto maxWakeLatency = mMaxWakeLatency.load(std::memory_order_relaxed);
+
+   if (wakeBatchSize <= 1 || maxWakeLatency <= 0)
+      return;
+
+   QDeadlineTimer deadline;
+   deadline.setPreciseRemainingTime(0, static_cast<qint64>(maxWakeLatency) * 1000);
+
    QMutexLocker locker(&mutex);
-   mQuit = true;
-   mQueueNotEmpty.wakeAll();
+
+   // The producer that completes the batch wakes the writer up before the deadline
+   while (!mQuit && !mIsStop && mPending.load(std::memory_order_acquire) < wakeBatchSize)
+   {
+      if (!mQueueNotEmpty.wait(&mutex, deadline))
+         break;
+   }
+}
+
+int QLoggerWriter::processBatch(int maxMessages)
+{
+   // The configurations replaced meanwhile are released between two batches, when the writer holds none of them
+   if (mHasRetiredConfigs.load(std::memory_order_relaxed))
+   {
+      QMutexLocker locker(&mConfigMutex);
+      releaseRetiredConfigs();
+   }
+
+   // The configuration is read once, so the whole batch is written with the same settings
+   const auto config = currentConfig();
+
+   // Buffered data of a persistent file is flushed when the interval expires even if nothing else is logged
+   if (!mWriteBuffer.isEmpty() && mLastFlush.hasExpired(config->flushInterval))
+      flushFile();
+
+   if (mIsStop)
+      return 0;
+
+   QVector<LogRecord> records;
+
+   {
+      QMutexLocker locker(&mPopMutex);
+      LogRecord record;
+
+      while (records.count() < maxMessages && mMessages.pop(record))
+         records.append(std::move(record));
+   }
+
+   const auto count = records.count();
+
+   if (count == 0)
+   {
+      completeFlushRequest(*config);
+      return 0;
+   }
+
+   mPending.fetch_sub(count, std::memory_order_acq_rel);
+
+   if (mQueueCapacity.load(std::memory_order_relaxed) > 0
+       && mQueuePolicy.load(std::memory_order_relaxed) == LogQueuePolicy::Block)
+   {
+      QMutexLocker locker(&mutex);
+      mQueueNotFull.wakeAll();
+   }
+
+   // Formatting is done here, in batch, so the logging threads only pay for queuing the raw record
+   mFormatter.updateClockOffset();
+   mFormatter.setLayout(config->messageOptions, config->timestampFormat, getLevel() <= LogLevel::Debug, mFileFormat);
+
+   reportDroppedMessages(records);
+
+   retractPendingData();
+
+   // Reserved once, then the lines of every batch are rendered into the same memory
+   if (mMode != LogMode::OnlyConsole && mWriteBuffer.capacity() < config->flushSize)
+      mWriteBuffer.reserve(config->flushSize);
+
+   const auto writeStart = LogRecord::currentTimestamp();
+
+   mSyncBatch = (mMode == LogMode::OnlyFile || mMode == LogMode::Full) && needsSync(*config, records);
+   mIndex.setInterval(mFileFormat == LogFileFormat::Binary ? 0 : config->indexInterval);
+
+   write(records);
+
+   // The open file gets the batch and the buffered data before being synchronized
+   if (mSyncBatch && mFile.isOpen())
+   {
+      flushFile();
+      syncFile(mFile);
+   }
+
+   publishPendingData();
+
+   mWriteTime.fetch_add(LogRecord::currentTimestamp() - writeStart, std::memory_order_relaxed);
+   mWrittenMessages.fetch_add(static_cast<quint64>(count), std::memory_order_relaxed);
+   mCompletedMessages.fetch_add(static_cast<quint64>(count), std::memory_order_release);
+   mBatches.fetch_add(1, std::memory_order_relaxed);
+   mLastBatchSize.store(count, std::memory_order_relaxed);
+
+   if (count > mMaxBatchSize.load(std::memory_order_relaxed))
+      mMaxBatchSize.store(count, std::memory_order_relaxed);
+
+   completeFlushRequest(*config);
+
+   return count;
+}
+
+bool QLoggerWriter::flush(int timeout)
+{
+   if (mMode == LogMode::Disabled)
+      return true;
+
+   if (mIsStop || (!mWorkerPool && !isRunning()) || QThread::currentThread() == this)
+      return false;
+
+   // Only the messages enqueued so far are waited for, the ones logged meanwhile do not delay the flush
+   const auto target = mEnqueuedMessages.load(std::memory_order_acquire);
+   auto currentTarget = mFlushTarget.load(std::memory_order_relaxed);
+
+   while (currentTarget < target
+          && !mFlushTarget.compare_exchange_weak(currentTarget, target, std::memory_order_acq_rel))
+   {
+   }
+
+   const auto request = mFlushRequest.fetch_add(1, std::memory_order_acq_rel) + 1;
+   const QDeadlineTimer deadline(timeout);
+
+   wakeUp();
+
+   QMutexLocker locker(&mutex);
+
+   while (mFlushedRequest.load(std::memory_order_acquire) < request)
+   {
+      if (!mFlushDone.wait(&mutex, deadline))
+         return mFlushedRequest.load(std::memory_order_acquire) >= request;
+   }
+
+   return true;
+}
+
+void QLoggerWriter::completeFlushRequest(const WriterConfig &config)
+{
+   if (!hasFlushRequest()
+       || mCompletedMessages.load(std::memory_order_acquire) < mFlushTarget.load(std::memory_order_acquire))
+   {
+      return;
+   }
+
+   const auto request = mFlushRequest.load(std::memory_order_acquire);
+
+   if (mFile.isOpen())
+   {
+      flushFile();
+
+      if (config.fsyncPolicy != LogFsyncPolicy::Never)
+         syncFile(mFile);
+   }
+
+   for (const auto sink : config.sinks)
+      sink->flush();
+
+   if (mMemoryDumpRequest.exchange(false, std::memory_order_acq_rel))
+      writeMemoryDump();
+
+   QMutexLocker locker(&mutex);
+   mFlushedRequest.store(request, std::memory_order_release);
+   mFlushDone.wakeAll();
+}
+
+bool QLoggerWriter::needsSync(const WriterConfig &config, const QVector<LogRecord> &records) const
+{
+   switch (config.fsyncPolicy)
+   {
+      case LogFsyncPolicy::Never:
+         return false;
+      case LogFsyncPolicy::PerBatch:
+         return true;
+      case LogFsyncPolicy::OnError:
+         return std::any_of(records.cbegin(), records.cend(),
+                            [](const LogRecord &record) { return record.level >= LogLevel::Error; });
+      case LogFsyncPolicy::Interval:
+         return !mLastSync.isValid() || mLastSync.hasExpired(config.fsyncInterval);
+   }
+
+   return false;
+}
+
+void QLoggerWriter::syncFile(QFile &file)
+{
+   file.flush();
+
+#ifdef Q_OS_WIN
+   _commit(file.handle());
+#else
+   ::fsync(file.handle());
+#endif
+
+   mLastSync.start();
+}
+
+void QLoggerWriter::dumpPendingData() const
+{
+   // The path is encoded in advance, opening the file is async-signal-safe
+   if (mMode == LogMode::Memory)
+   {
+#ifdef Q_OS_WIN
+      const auto fd = _open(mDumpPath.constData(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+      const auto fd = ::open(mDumpPath.constData(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+#endif
+
+      if (fd < 0)
+         return;
+
+      mMemory.dump(fd);
+
+#ifdef Q_OS_WIN
+      _close(fd);
+#else
+      ::close(fd);
+#endif
+      return;
+   }
+
+   const auto handle = mDumpHandle.load(std::memory_order_acquire);
+
+   // A mapped file has its data in the mapping already, only a persistent file keeps it in memory
+   if (handle < 0 || mMappedFile)
+      return;
+
+   // The buffer is never read directly: the writer thread could be rendering into it or writing it meanwhile. The
+   // range is only used if its pointer is the same before and after reading its size.
+   auto data = mDumpData.load(std::memory_order_seq_cst);
+   auto size = mDumpSize.load(std::memory_order_seq_cst);
+
+   if (!data || mDumpData.load(std::memory_order_seq_cst) != data)
+      return;
+
+   while (size > 0)
+   {
+#ifdef Q_OS_WIN
+      const auto chunk = static_cast<unsigned int>(qMin<qint64>(size, INT_MAX));
+      const auto written = static_cast<qint64>(_write(handle, data, chunk));
+#else
+      const auto written = static_cast<qint64>(::write(handle, data, static_cast<size_t>(size)));
+#endif
+
+      if (written <= 0)
+         return;
+
+      data += written;
+      size -= written;
+   }
+}
+
+WriterStatistics QLoggerWriter::getStatistics() const
+{
+   WriterStatistics statistics;
+   statistics.fileDestination = mFileDestination;
+   statistics.enqueuedMessages = mEnqueuedMessages.load(std::memory_order_relaxed);
+   statistics.writtenMessages = mWrittenMessages.load(std::memory_order_relaxed);
+   statistics.droppedMessages = mTotalDroppedMessages.load(std::memory_order_relaxed);
+   statistics.queueDepth = qMax(0, mPending.load(std::memory_order_relaxed));
+   statistics.maxQueueDepth = mMaxQueueDepth.load(std::memory_order_relaxed);
+   statistics.bytesWritten = mBytesWritten.load(std::memory_order_relaxed);
+   statistics.batches = mBatches.load(std::memory_order_relaxed);
+   statistics.lastBatchSize = mLastBatchSize.load(std::memory_order_relaxed);
+   statistics.maxBatchSize = mMaxBatchSize.load(std::memory_order_relaxed);
+   statistics.writeTimeNs = mWriteTime.load(std::memory_order_relaxed);
+   statistics.rotations = mRotations.load(std::memory_order_relaxed);
+   statistics.enqueueWaitNs = mEnqueueWaitTime.load(std::memory_order_relaxed);
+
+   return statistics;
+}
+
+void QLoggerWriter::reportDroppedMessages(QVector<LogRecord> &records)
+{
+   // The report waits until the queue is back under half of its capacity
+   if (mDroppedMessages.load(std::memory_order_relaxed) == 0
+       || mPending.load(std::memory_order_acquire) > mQueueCapacity.load(std::memory_order_relaxed) / 2)
+   {
+      return;
+   }
+
+   const auto dropped = mDroppedMessages.exchange(0, std::memory_order_relaxed);
+
+   LogRecord record;
+   record.timestamp = LogRecord::currentTimestamp();
+   record.threadId = QString("%1").arg((quintptr)QThread::currentThread(), QT_POINTER_SIZE * 2, 16, QChar('0'));
+   record.level = LogLevel::Warning;
+   record.module = QStringLiteral("QLogger");
+   record.message = QString("%1 messages were dropped because the queue was full").arg(dropped);
+
+   records.append(std::move(record));
+}
+
+void QLoggerWriter::closeDestination()
+{
+   {
+      QMutexLocker locker(&mutex);
+      mQuit = true;
+      mQueueNotEmpty.wakeAll();
+      mQueueNotFull.wakeAll();
+   }
+
+   // Without its own thread the queue is drained and the file closed here: the owner has already stopped the worker
+   // pool
+   if (mWorkerPool)
+   {
+      while (processBatch(std::numeric_limits<int>::max()) > 0)
+         ;
+
+      closeFile();
+      closeSinks();
+   }
 }
 
 }
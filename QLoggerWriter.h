@@ -22,16 +22,55 @@
  ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***************************************************************************************/
 
+#include <QLoggerBinary.h>
+#include <QLoggerConsole.h>
+#include <QLoggerDataEnd.h>
+#include <QLoggerFormatter.h>
+#include <QLoggerIndex.h>
 #include <QLoggerLevel.h>
+#include <QLoggerQueue.h>
+#include <QLoggerRecord.h>
+#include <QLoggerRingBuffer.h>
+#include <QLoggerRotation.h>
+#include <QLoggerSink.h>
+#include <QLoggerStatistics.h>
 
 #include <QThread>
 #include <QWaitCondition>
 #include <QMutex>
 #include <QVector>
+#include <QFile>
+#include <QElapsedTimer>
+
+#include <atomic>
 
 namespace QLogger
 {
 
+class QLoggerWorkerPool;
+
+/**
+ * @brief The WriterConfig struct holds the settings of a writer that can be changed while it runs. They are published
+ * as a whole: a change copies the current configuration and swaps the pointer, so the logging threads and the writer
+ * thread always read a consistent set of values without taking a lock.
+ */
+struct WriterConfig
+{
+   int maxFileSize = 1024 * 1024; //! @note 1Mio
+   LogMessageDisplays messageOptions = LogMessageDisplay::Default;
+   LogTimestampFormat timestampFormat = LogTimestampFormat::EpochSeconds;
+   int flushSize = 64 * 1024;
+   int flushInterval = 1000;
+   LogFsyncPolicy fsyncPolicy = LogFsyncPolicy::Never;
+   int fsyncInterval = 1000;
+   /**
+    * @brief Outputs added to the built-in file and console, owned by the writer.
+    */
+   QVector<QLoggerSink *> sinks;
+   int memoryCapacity = 4 * 1024 * 1024;
+   qint64 indexInterval = 0;
+};
+
 class QLoggerWriter : public QThread
 {
    Q_OBJECT
@@ -51,6 +90,11 @@ public:
                           LogFileDisplay fileSuffixIfFull = LogFileDisplay::DateTime,
                           LogMessageDisplays messageOptions = LogMessageDisplay::Default);
 
+   /**
+    * @brief Destructor that releases the configurations published during the life of the writer.
+    */
+   ~QLoggerWriter() override;
+
    /**
     * @brief Gets path and folder of the file that will store the logs.
     */
@@ -60,11 +104,19 @@ public:
     */
    QString getFileDestination() const { return mFileDestination; }
 
+   /**
+    * @brief Gets the complete path of the file where a writer built with the given parameters logs.
+    * @param fileDestination The file name.
+    * @param fileFolderDestination The complete folder destination.
+    * @return The path and name of the file.
+    */
+   static QString resolveFileDestination(const QString &fileDestination, const QString &fileFolderDestination);
+
    /**
     * @brief Gets the current logging mode.
     * @return The level.
     */
-   LogMode getMode() const { return mMode; }
+   LogMode getMode() const { return mMode.load(std::memory_order_relaxed); }
 
    /**
     * @brief setLogMode Sets the log mode for this destination.
@@ -76,87 +128,578 @@ public:
     * @brief Gets the current level threshold.
     * @return The level.
     */
-   LogLevel getLevel() const { return mLevel; }
+   LogLevel getLevel() const { return mLevel.load(std::memory_order_relaxed); }
 
    /**
     * @brief setLogLevel Sets the log level for this destination.
     * @param level The new level threshold.
     */
-   void setLogLevel(LogLevel level) { mLevel = level; }
+   void setLogLevel(LogLevel level) { mLevel.store(level, std::memory_order_relaxed); }
 
    /**
     * @brief Gets the current max size for the log file.
     * @return The maximum size
     */
-   int getMaxFileSize() const { return mMaxFileSize; }
+   int getMaxFileSize() const { return currentConfig()->maxFileSize; }
 
    /**
     * @brief setMaxFileSize Sets the max file size for this destination.
     * @param maxSize The new file size
     */
-   void setMaxFileSize(int maxSize) { mMaxFileSize = maxSize; }
+   void setMaxFileSize(int maxSize)
+   {
+      updateConfig([maxSize](WriterConfig &config) { config.maxFileSize = maxSize; });
+   }
+
+   /**
+    * @brief getFileAccess Gets how the log file is accessed.
+    * @return The file access
+    */
+   LogFileAccess getFileAccess() const { return mFileAccess; }
+
+   /**
+    * @brief setFileAccess Sets how the log file is accessed. With LogFileAccess::Persistent the file is kept open and
+    * the writes are buffered following the flush policy. With LogFileAccess::MemoryMapped the batches are copied into
+    * a mapping of the file instead.
+    * @param fileAccess The file access
+    */
+   void setFileAccess(LogFileAccess fileAccess) { mFileAccess = fileAccess; }
+
+   /**
+    * @brief getFileFormat Gets how the messages are stored in the log file.
+    * @return The file format
+    */
+   LogFileFormat getFileFormat() const { return mFileFormat; }
+
+   /**
+    * @brief setFileFormat Sets how the messages are stored in the log file. It must be set before the writer starts.
+    * Binary files are always kept open, whatever the file access is.
+    * @param fileFormat The file format
+    */
+   void setFileFormat(LogFileFormat fileFormat) { mFileFormat = fileFormat; }
+
+   /**
+    * @brief getCompression Gets how the rotated files are compressed.
+    * @return The compression
+    */
+   LogCompression getCompression() const { return mRotation.getCompression(); }
+
+   /**
+    * @brief setCompression Sets how the rotated files are compressed. The compression runs in the background.
+    * @param compression The compression
+    */
+   void setCompression(LogCompression compression) { mRotation.setCompression(compression); }
+
+   /**
+    * @brief setRetention Sets which rotated files are kept. The oldest files beyond the limits are removed in the
+    * background after every rotation. A value of zero means no limit.
+    * @param maxFiles The maximum amount of rotated files.
+    * @param maxTotalSize The maximum amount of bytes of all the rotated files.
+    * @param maxAgeDays The maximum age in days of a rotated file.
+    */
+   void setRetention(int maxFiles, qint64 maxTotalSize, int maxAgeDays)
+   {
+      mRotation.setRetention(maxFiles, maxTotalSize, maxAgeDays);
+   }
+
+   /**
+    * @brief setFlushPolicy Sets when the buffered data of a persistent file is written. The data is flushed as soon
+    * as one of the two limits is reached.
+    * @param flushSize The maximum amount of bytes kept in memory.
+    * @param flushInterval The maximum time in milliseconds the data is kept in memory.
+    */
+   void setFlushPolicy(int flushSize, int flushInterval);
+
+   /**
+    * @brief getFsyncPolicy Gets when the log file is synchronized to the disk.
+    * @return The policy
+    */
+   LogFsyncPolicy getFsyncPolicy() const { return currentConfig()->fsyncPolicy; }
+
+   /**
+    * @brief setFsyncPolicy Sets when the log file is synchronized to the disk. The buffered data of a persistent file
+    * is written before every synchronization.
+    * @param policy The policy.
+    * @param interval With LogFsyncPolicy::Interval, the minimum time in milliseconds between two synchronizations.
+    */
+   void setFsyncPolicy(LogFsyncPolicy policy, int interval = 1000);
+
+   /**
+    * @brief Gets the maximum amount of messages waiting to be written. Zero means no limit.
+    * @return The capacity
+    */
+   int getQueueCapacity() const { return mQueueCapacity.load(std::memory_order_relaxed); }
+
+   /**
+    * @brief Gets what happens when a message is logged and the queue is full.
+    * @return The policy
+    */
+   LogQueuePolicy getQueuePolicy() const { return mQueuePolicy.load(std::memory_order_relaxed); }
+
+   /**
+    * @brief setQueueCapacity Limits the amount of messages waiting to be written. The messages dropped because of
+    * the limit are counted and reported in the log once the queue is back under half of its capacity.
+    * @param capacity The maximum amount of messages. Zero means no limit.
+    * @param policy What to do when the queue is full.
+    * @param dropLevel With LogQueuePolicy::DropBelowLevel, the messages with a lower level are dropped.
+    */
+   void setQueueCapacity(int capacity, LogQueuePolicy policy = LogQueuePolicy::DropNewest,
+                         LogLevel dropLevel = LogLevel::Warning);
+
+   /**
+    * @brief setWakePolicy Sets how often the writer thread is woken up. By default it is woken up when the first
+    * message arrives to an empty queue. With a batch size greater than one, the writer then waits until the batch is
+    * complete or the latency has passed, so several messages are written at once. Writers served by a worker pool
+    * only honour the batch size to schedule themselves.
+    *
+    * @param batchSize The amount of pending messages that wakes the writer up.
+    * @param maxLatency The maximum time in microseconds a message waits for its batch. The batch size only applies
+    * if it is greater than zero.
+    */
+   void setWakePolicy(int batchSize, int maxLatency);
+
+   /**
+    * @brief getTimestampFormat Gets how the date and time of the messages are written.
+    * @return The timestamp format
+    */
+   LogTimestampFormat getTimestampFormat() const { return currentConfig()->timestampFormat; }
+
+   /**
+    * @brief setTimestampFormat Sets how the date and time of the messages are written.
+    * @param timestampFormat The timestamp format
+    */
+   void setTimestampFormat(LogTimestampFormat timestampFormat)
+   {
+      updateConfig([timestampFormat](WriterConfig &config) { config.timestampFormat = timestampFormat; });
+   }
+
+   /**
+    * @brief getConsoleOptions Gets how the messages are written in the console.
+    * @return The console options
+    */
+   LogConsoleOptions getConsoleOptions() const { return mConsole.getOptions(); }
+
+   /**
+    * @brief setConsoleOptions Sets how the messages are written in the console with LogMode::OnlyConsole and
+    * LogMode::Full. It must be set before the writer starts.
+    * @param consoleOptions The console options
+    */
+   void setConsoleOptions(LogConsoleOptions consoleOptions) { mConsole.setOptions(consoleOptions); }
+
+   /**
+    * @brief getConsoleLevel Gets the minimum level of the messages written in the console.
+    * @return The level
+    */
+   LogLevel getConsoleLevel() const { return mConsole.getLevel(); }
+
+   /**
+    * @brief setConsoleLevel Sets the minimum level of the messages written in the console, on top of the level of the
+    * writer. It can be changed while the writer runs.
+    * @param level The level
+    */
+   void setConsoleLevel(LogLevel level) { mConsole.setLevel(level); }
+
+   /**
+    * @brief addSink Adds an output that receives every batch written, after the built-in file and console. It can be
+    * added while the writer runs.
+    * @param sink The sink. The writer takes its ownership and destroys it with itself.
+    */
+   void addSink(QLoggerSink *sink);
+
+   /**
+    * @brief getSinks Gets the outputs added to the writer.
+    * @return The sinks, still owned by the writer.
+    */
+   QVector<QLoggerSink *> getSinks() const { return currentConfig()->sinks; }
 
    /**
     * @brief getMessageOptions Gets the current message options.
     * @return The current options
     */
-   LogMessageDisplays getMessageOptions() const { return mMessageOptions; }
+   LogMessageDisplays getMessageOptions() const { return currentConfig()->messageOptions; }
 
    /**
     * @brief setMessageOptions Specifies what elements are displayed in one line of log message.
     * @param messageOptions The options
     */
-   void setMessageOptions(LogMessageDisplays messageOptions) { mMessageOptions = messageOptions; }
+   void setMessageOptions(LogMessageDisplays messageOptions)
+   {
+      updateConfig([messageOptions](WriterConfig &config) { config.messageOptions = messageOptions; });
+   }
+
+   /**
+    * @brief The ConfigReference class keeps the configuration it points to alive: the configurations replaced by a
+    * change are only released once no reference is left.
+    */
+   class ConfigReference
+   {
+   public:
+      explicit ConfigReference(const QLoggerWriter &writer);
+      ConfigReference(ConfigReference &&other) noexcept
+         : mConfig(other.mConfig)
+         , mReaders(other.mReaders)
+      {
+         other.mReaders = nullptr;
+      }
+      ~ConfigReference();
+
+      ConfigReference(const ConfigReference &) = delete;
+      ConfigReference &operator=(const ConfigReference &) = delete;
+      ConfigReference &operator=(ConfigReference &&) = delete;
+
+      const WriterConfig &operator*() const { return *mConfig; }
+      const WriterConfig *operator->() const { return mConfig; }
+
+   private:
+      const WriterConfig *mConfig = nullptr;
+      std::atomic<int> *mReaders = nullptr;
+   };
+
+   /**
+    * @brief currentConfig Gets the configuration currently published. It is lock-free and the values never tear: a
+    * change publishes a new configuration instead of modifying this one.
+    * @return A reference to the configuration, that stays valid as long as the reference is kept.
+    */
+   ConfigReference currentConfig() const { return ConfigReference(*this); }
+
+   /**
+    * @brief enqueue Enqueues a message to be written in the destination. It never blocks other producers: the
+    * record is pushed into a lock-free queue and the writer thread is only woken up when the queue was empty.
+    * The record is formatted later on by the writer thread.
+    * @param record The raw data of the message to log.
+    * @param mayBlock If false a full queue with LogQueuePolicy::Block takes the record anyway instead of waiting.
+    */
+   void enqueue(LogRecord &&record, bool mayBlock = true);
+
+   /**
+    * @brief flush Waits until the messages enqueued before the call are written, and the buffered data of the file
+    * is handed to the system. The file is synchronized to the disk unless the fsync policy is LogFsyncPolicy::Never.
+    * @param timeout The maximum time to wait in milliseconds, -1 to wait forever.
+    * @return True if the messages have been written, false on timeout or if the writer is paused or not running.
+    */
+   bool flush(int timeout = -1);
 
    /**
-    * @brief enqueue Enqueues a message to be written in the destination.
-    * @param date The date and time of the log message.
-    * @param threadId The thread where the message comes from.
-    * @param module The module that writes the message.
-    * @param level The log level of the message.
-    * @param function The function that prints the log.
-    * @param fileName The file name that prints the log.
-    * @param line The line of the file name that prints the log.
-    * @param message The message to log.
+    * @brief dumpPendingData Writes the data already rendered and not written yet into the open file. It only uses
+    * async-signal-safe calls, so it can be called from a crash handler. It is a best effort: the messages still in
+    * the queue are not rendered.
     */
-   void enqueue(const QDateTime &date, const QString &threadId, const QString &module, LogLevel level,
-                const QString &function, const QString &fileName, int line, const QString &message);
+   void dumpPendingData() const;
+
+   /**
+    * @brief getMemoryCapacity Gets the amount of memory that keeps the messages with LogMode::Memory.
+    * @return The size in bytes
+    */
+   int getMemoryCapacity() const { return currentConfig()->memoryCapacity; }
+
+   /**
+    * @brief setMemoryCapacity Sets the amount of memory that keeps the last messages with LogMode::Memory. The
+    * messages kept so far are dropped when it changes.
+    * @param capacity The size in bytes.
+    */
+   void setMemoryCapacity(int capacity)
+   {
+      updateConfig([capacity](WriterConfig &config) { config.memoryCapacity = capacity; });
+   }
+
+   /**
+    * @brief getIndexInterval Gets the size of the blocks of the index written alongside the text log files.
+    * @return The size in bytes, zero when the files are not indexed.
+    */
+   qint64 getIndexInterval() const { return currentConfig()->indexInterval; }
+
+   /**
+    * @brief setIndexInterval Sets the size of the blocks of the index written alongside the text log files, that
+    * QLoggerReader uses to skip the parts out of a query. The binary files are not indexed.
+    * @param interval The size in bytes, zero to stop indexing.
+    */
+   void setIndexInterval(qint64 interval)
+   {
+      updateConfig([interval](WriterConfig &config) { config.indexInterval = interval; });
+   }
+
+   /**
+    * @brief dumpMemory Appends the messages kept in memory with LogMode::Memory to the log file, once the messages
+    * enqueued before the call are in the memory. The messages dumped are dropped from the memory.
+    * @param timeout The maximum time to wait in milliseconds, -1 to wait forever.
+    * @return True if the memory has been dumped, false on timeout or with another mode.
+    */
+   bool dumpMemory(int timeout = -1);
 
    /**
     * @brief Stops the log writer
     * @param stop True to be stop, otherwise false
     */
-   void stop(bool stop) { mIsStop = stop; }
+   void stop(bool stop);
 
    /**
     * @brief Returns if the log writer is stop from writing.
     * @return True if is stop, otherwise false
     */
-   bool isStop() const { return mIsStop; }
+   bool isStop() const { return mIsStop.load(std::memory_order_relaxed); }
+
+   /**
+    * @brief Gets the pool that writes the messages, if any.
+    * @return The pool or nullptr if the writer uses its own thread.
+    */
+   QLoggerWorkerPool *getWorkerPool() const { return mWorkerPool; }
+
+   /**
+    * @brief setWorkerPool Makes a pool write the messages instead of the own thread of the writer. It must be set
+    * before the writer starts.
+    * @param pool The pool.
+    */
+   void setWorkerPool(QLoggerWorkerPool *pool) { mWorkerPool = pool; }
+
+   /**
+    * @brief getStatistics Gets a snapshot of the counters of the writer. It can be called from any thread.
+    * @return The statistics, without the modules.
+    */
+   WriterStatistics getStatistics() const;
 
    /**
     * @brief run Overloaded method from QThread used to wait for new messages.
     */
    void run() override;
 
+   /**
+    * @brief processBatch Writes the pending messages. It is called by the own thread of the writer or by one thread
+    * of the worker pool at a time.
+    * @param maxMessages The maximum amount of messages to write.
+    * @return The amount of messages written.
+    */
+   int processBatch(int maxMessages);
+
+   /**
+    * @brief hasPendingMessages Checks if there are messages waiting to be written.
+    * @return True if there are pending messages, otherwise false.
+    */
+   bool hasPendingMessages() const { return !mIsStop && mPending.load(std::memory_order_acquire) > 0; }
+
    /**
     * @brief closeDestination Closes the destination. This needs to be called whenever
     */
    void closeDestination();
 
 private:
-   bool mQuit = false;
-   bool mIsStop = false;
+   friend class QLoggerWorkerPool;
+
+   std::atomic<bool> mQuit { false };
+   std::atomic<bool> mIsStop { false };
    QWaitCondition mQueueNotEmpty;
+   QWaitCondition mQueueNotFull;
    QString mFileDestinationFolder;
    QString mFileDestination;
    LogFileDisplay mFileSuffixIfFull;
-   LogMode mMode;
-   LogLevel mLevel;
-   int mMaxFileSize = 1024 * 1024; //! @note 1Mio
-   LogMessageDisplays mMessageOptions;
-   QVector<QString> mMessages;
+   std::atomic<LogMode> mMode;
+   std::atomic<LogLevel> mLevel;
+   LogFileAccess mFileAccess = LogFileAccess::OpenPerBatch;
+   LogFileFormat mFileFormat = LogFileFormat::Text;
+
+   /**
+    * @brief The settings that can be changed while the writer runs. The configurations replaced are kept until no
+    * ConfigReference is counted in mConfigReaders, since a reader may still be using them. The readers are the
+    * thread writing the batches and the getters: the logging threads only read the atomics of the queue below, so
+    * the count is back to zero after every batch.
+    */
+   std::atomic<const WriterConfig *> mConfig { nullptr };
+   QVector<const WriterConfig *> mRetiredConfigs;
+   mutable std::atomic<int> mConfigReaders { 0 };
+   std::atomic<bool> mHasRetiredConfigs { false };
+
+   /**
+    * @brief The settings of the queue and of the wake policy, read by enqueue on every message. They are kept out of
+    * WriterConfig so the logging threads never hold a configuration, and a mix of old and new values for the time
+    * of a change is harmless.
+    */
+   std::atomic<int> mQueueCapacity { 0 };
+   std::atomic<LogQueuePolicy> mQueuePolicy { LogQueuePolicy::DropNewest };
+   std::atomic<LogLevel> mDropLevel { LogLevel::Warning };
+   std::atomic<int> mWakeBatchSize { 1 };
+   std::atomic<int> mMaxWakeLatency { 0 };
+   /**
+    * @brief Serializes the changes of the configuration, never taken to read it.
+    */
+   QMutex mConfigMutex;
+
+   /**
+    * @brief Members used only by the writer thread to format and encode the records.
+    */
+   QLoggerFormatter mFormatter;
+   QLoggerBinaryEncoder mEncoder;
+   QLoggerConsole mConsole;
+   /**
+    * @brief The records of a batch accepted by a sink with a higher level than some of them.
+    */
+   QVector<LogRecord> mSinkRecords;
+
+   /**
+    * @brief Members used only by the writer thread when the file is kept open.
+    */
+   QLoggerRotation mRotation;
+   QLoggerIndexWriter mIndex;
+   QFile mFile;
+   qint64 mFileSize = 0;
+   QByteArray mWriteBuffer;
+   QElapsedTimer mLastFlush;
+   QElapsedTimer mLastSync;
+   /**
+    * @brief Set when the batch being written has to be synchronized following the fsync policy.
+    */
+   bool mSyncBatch = false;
+   /**
+    * @brief Descriptor of the open file for the crash handler, -1 when it is closed.
+    */
+   std::atomic<int> mDumpHandle { -1 };
+   /**
+    * @brief The data of mWriteBuffer not written yet, as published for the crash handler. The pointer is null while
+    * the writer modifies the buffer, so the handler never reads memory being rendered or reallocated.
+    */
+   std::atomic<const char *> mDumpData { nullptr };
+   std::atomic<qint64> mDumpSize { 0 };
+   uchar *mMappedFile = nullptr;
+   qint64 mMappedSize = 0;
+   /**
+    * @brief The end of the data of the mapped file, kept on disk for the next run and for the readers.
+    */
+   QLoggerDataEndWriter mDataEnd;
+
+   /**
+    * @brief The last messages of LogMode::Memory, and the path where the crash handler dumps them.
+    */
+   QLoggerRingBuffer mMemory;
+   QByteArray mDumpPath;
+   std::atomic<bool> mMemoryDumpRequest { false };
+
+   /**
+    * @brief Messages dropped since the last report in the log.
+    */
+   std::atomic<int> mDroppedMessages { 0 };
+
+   QLoggerWorkerPool *mWorkerPool = nullptr;
+   /**
+    * @brief Set while the writer is waiting in the queue of the worker pool or being processed by it.
+    */
+   std::atomic<bool> mScheduled { false };
+
+   QLoggerQueue<LogRecord> mMessages;
+   /**
+    * @brief Number of messages pushed and not yet taken by the writer thread. It can be transiently negative
+    * since producers increment it after pushing.
+    */
+   std::atomic<int> mPending { 0 };
+   /**
+    * @brief Counters of the statistics updated by the logging threads. They are next to mPending, so they add no
+    * cache line to enqueue.
+    */
+   std::atomic<quint64> mEnqueuedMessages { 0 };
+   std::atomic<int> mMaxQueueDepth { 0 };
+   std::atomic<quint64> mTotalDroppedMessages { 0 };
+   std::atomic<qint64> mEnqueueWaitTime { 0 };
+   /**
+    * @brief Counters of the statistics updated by the thread writing the batches.
+    */
+   std::atomic<quint64> mWrittenMessages { 0 };
+   std::atomic<quint64> mBytesWritten { 0 };
+   std::atomic<quint64> mBatches { 0 };
+   std::atomic<int> mLastBatchSize { 0 };
+   std::atomic<int> mMaxBatchSize { 0 };
+   std::atomic<qint64> mWriteTime { 0 };
+   std::atomic<quint64> mRotations { 0 };
+   /**
+    * @brief Messages written or evicted by LogQueuePolicy::DropOldest, compared with mEnqueuedMessages by flush.
+    */
+   std::atomic<quint64> mCompletedMessages { 0 };
+   /**
+    * @brief Flush requests: the amount of messages to complete, the last request and the last request done.
+    */
+   std::atomic<quint64> mFlushTarget { 0 };
+   std::atomic<quint64> mFlushRequest { 0 };
+   std::atomic<quint64> mFlushedRequest { 0 };
+   QWaitCondition mFlushDone;
+   /**
+    * @brief Only protects the sleep/wake-up handshake with the writer thread, never the queue itself.
+    */
    QMutex mutex;
+   /**
+    * @brief Serializes the consumers of the queue: the writer thread and the producers dropping the oldest message.
+    */
+   QMutex mPopMutex;
+
+   /**
+    * @brief updateConfig Publishes a copy of the current configuration with a change applied.
+    * @param change Function that modifies the copy.
+    */
+   template<typename Change>
+   void updateConfig(Change change)
+   {
+      QMutexLocker locker(&mConfigMutex);
+
+      const auto config = new WriterConfig(*currentConfig());
+      change(*config);
+
+      mRetiredConfigs.append(mConfig.exchange(config, std::memory_order_seq_cst));
+      mHasRetiredConfigs.store(true, std::memory_order_relaxed);
+
+      releaseRetiredConfigs();
+   }
+
+   /**
+    * @brief releaseRetiredConfigs Deletes the configurations replaced if nobody reads a configuration. Must be called
+    * with mConfigMutex held.
+    */
+   void releaseRetiredConfigs();
+
+   /**
+    * @brief makeRoom Applies the queue policy when the queue is full.
+    * @param policy The queue policy read by enqueue.
+    * @param level The level of the new message.
+    * @return True if the new message can be queued, false if it has to be dropped.
+    */
+   bool makeRoom(LogQueuePolicy policy, LogLevel level);
+
+   /**
+    * @brief waitForBatch Waits for the rest of the batch after the writer thread has been woken up.
+    */
+   void waitForBatch();
+
+   /**
+    * @brief reportDroppedMessages Adds a record with the amount of dropped messages once the queue has room again.
+    * @param records The batch where the record is added.
+    */
+   void reportDroppedMessages(QVector<LogRecord> &records);
+
+   /**
+    * @brief wakeUp Wakes up the writer thread.
+    */
+   void wakeUp();
+
+   /**
+    * @brief hasFlushRequest Checks if a flush is waiting to be completed.
+    */
+   bool hasFlushRequest() const
+   {
+      return mFlushRequest.load(std::memory_order_acquire) != mFlushedRequest.load(std::memory_order_acquire);
+   }
+
+   /**
+    * @brief completeFlushRequest Completes the pending flush requests once their messages have been written.
+    * @param config The configuration with the fsync policy.
+    */
+   void completeFlushRequest(const WriterConfig &config);
+
+   /**
+    * @brief needsSync Checks if a batch has to be synchronized to the disk following the fsync policy.
+    * @param config The configuration with the fsync policy.
+    * @param records The records of the batch.
+    */
+   bool needsSync(const WriterConfig &config, const QVector<LogRecord> &records) const;
+
+   /**
+    * @brief syncFile Synchronizes a file to the disk.
+    * @param file The open file.
+    */
+   void syncFile(QFile &file);
 
    /**
     * @brief renameFileIfFull Truncates the log file in two. Keeps the filename for the new one and renames the old one
@@ -167,23 +710,113 @@ private:
    QString renameFileIfFull();
 
    /**
-    * @brief generateDuplicateFilename
+    * @brief Gets the folder where a writer built with the given folder logs.
+    * @param fileFolderDestination The complete folder destination, empty for the default one.
+    * @return The folder ended by a slash.
+    */
+   static QString resolveFileDestinationFolder(const QString &fileFolderDestination);
+
+   /**
+    * @brief renameFile Renames the log file with the timestamp or with a file number, and hands it over to be
+    * compressed and to apply the retention.
     *
-    * @param fileDestination The file path and name without the extension.
-    * @param fileExtension The file extension
-    * @param fileSuffixNumber The file suffix number.
-    * @return The complete path of the duplicated file name.
+    * @return Returns the file name for the old logs, once archived.
     */
-   static QString generateDuplicateFilename(const QString &fileDestination, const QString &fileExtension,
-                                            int fileSuffixNumber = 1);
+   QString renameFile();
 
    /**
-    * @brief Writes a message in a file. If the file is full, it truncates it and prints a first line with the
-    * information of the old file.
+    * @brief Writes a batch of records in the destination: the built-in file or console following the mode, and then
+    * every sink added. If the file is full, it truncates it and prints a first line with the information of the old
+    * file.
     *
-    * @param message Pair of values consistent on the date and the message to be log.
+    * @param records The records to be log.
+    */
+   void write(const QVector<LogRecord> &records);
+
+   /**
+    * @brief writeToFilePerBatch Opens the file, writes the records and closes it again, with
+    * LogFileAccess::OpenPerBatch.
+    * @param records The records to write.
+    */
+   void writeToFilePerBatch(const QVector<LogRecord> &records);
+
+   /**
+    * @brief writeToSink Hands a batch to a sink with only the records it accepts.
+    * @param sink The sink.
+    * @param records The records of the batch.
+    */
+   void writeToSink(QLoggerSink &sink, const QVector<LogRecord> &records);
+
+   /**
+    * @brief writeToMemory Renders the records into the memory with LogMode::Memory, and dumps it on a Fatal message.
+    * @param records The records to write.
+    */
+   void writeToMemory(const QVector<LogRecord> &records);
+
+   /**
+    * @brief writeMemoryDump Appends the messages kept in memory to the log file and drops them from the memory.
+    */
+   void writeMemoryDump();
+
+   /**
+    * @brief closeSinks Closes the sinks added once nothing else is written.
+    */
+   void closeSinks();
+
+   /**
+    * @brief writeToOpenFile Renders the records into the write buffer of the open file, opening or rotating it when
+    * needed.
+    * @param records The records to be log.
+    */
+   void writeToOpenFile(const QVector<LogRecord> &records);
+
+   /**
+    * @brief appendMessages Renders the lines of the records at the end of the write buffer, and copies them to the
+    * console with LogMode::Full. The lines are added to the index of the file.
+    * @param records The records to be log.
+    * @param fileOffset The position in the file of the start of the write buffer.
+    */
+   void appendMessages(const QVector<LogRecord> &records, qint64 fileOffset);
+
+   /**
+    * @brief writeToBinaryFile Encodes the records into the write buffer of the open file, opening or rotating it
+    * when needed.
+    * @param records The records to be log.
+    */
+   void writeToBinaryFile(const QVector<LogRecord> &records);
+
+   /**
+    * @brief openFile Opens the log file if it is not open yet, rotating it first if it is full.
+    * @param prevFilename Set to the name of the old logs if the file has been rotated.
+    * @return True if the file is open, otherwise false.
+    */
+   bool openFile(QString &prevFilename);
+
+   /**
+    * @brief recoverMappedFile Truncates a mapped log file that its writer did not close to the end of its data, as
+    * saved in its QLoggerDataEnd marker. A file closed cleanly has no marker and is left as it is.
+    */
+   void recoverMappedFile();
+
+   /**
+    * @brief flushFile Writes the buffered data into the open file.
+    */
+   void flushFile();
+
+   /**
+    * @brief publishPendingData Publishes the data of mWriteBuffer for the crash handler, once the batch is rendered.
+    */
+   void publishPendingData();
+
+   /**
+    * @brief retractPendingData Hides mWriteBuffer from the crash handler before the buffer is modified or written.
+    */
+   void retractPendingData() { mDumpData.store(nullptr, std::memory_order_seq_cst); }
+
+   /**
+    * @brief closeFile Flushes and closes the open file, if any. A mapped file is truncated to the size of its data.
     */
-   void write(QVector<QString> messages);
+   void closeFile();
 };
 
 }